@@ -1,23 +1,125 @@
 /* Reads in input.txt. input.txt gives
-   start and goal locations, one of four
-   search algorithms (BFS, DFS, UCS, A*),
+   start and goal locations, one of the
+   search algorithms (BFS, DFS, UCS, A*, ALT, CH,
+   BIUCS, BIA*, DELTA, IDA*, IDDFS),
    and live and Sunday traffic information.
    Program uses given algorithm to find path
    from start location to goal location.
    Program writes path and accumulated time
    from start to each location in output.txt.
+
+   main.exe --batch [queries.txt] [--threads N] loads
+   the traffic information in input.txt once, then answers
+   one "ALG START GOAL" query per line of queries.txt (or
+   standard input) on N threads (default: all cores).
+   Each answer is written to standard output as one line
+   of locations and accumulated times, in query order,
+   as soon as it and the queries before it are answered.
+   A line "UPDATE A B COST" changes a live road cost for
+   the queries after it. Repeated queries are answered
+   from a cache of --cache MB (default 64, 0 turns it off).
+
+   --stats [stats.txt] writes one JSON line per search to
+   stats.txt (or standard error): nodes expanded and
+   generated, duplicates, peak frontier and explored
+   sizes, bytes allocated, parse and search time.
+
+   main.exe --build-heuristics goals.txt tables.txt writes
+   exact cost tables to each location named in goals.txt.
+   --heuristics tables.txt loads them; A*, IDA* and BIA*
+   then use the table of each query's goal, falling back
+   to the Sunday table of input.txt for other goals and
+   after an UPDATE.
+
+   main.exe --generate grid|road|random|zero EDGES file.txt
+   [--seed S] writes a synthetic network of about EDGES
+   roads in input.txt format, with a consistent Sunday
+   table ("zero" has zero-cost roads and loops).
+   main.exe --bench [MAXEDGES] runs BFS, DFS, UCS, A* and
+   DELTA on each style from 1000 roads up to MAXEDGES
+   (default 10^7), reporting time, expansions and memory,
+   and checks UCS, A* and DELTA costs against Dijkstra,
+   as well as a --replan repair with --heuristics tables.
+
+   main.exe --convert input.txt graph.bin writes the
+   traffic information in input.txt as a binary graph
+   (string table, CSR edges and Sunday heuristic).
+   main.exe --batch --graph graph.bin memory-maps that
+   file instead of parsing input.txt.
+
+   main.exe --replan [deltas.txt] plans the route in
+   input.txt, then reads "A B COST" live traffic changes
+   from deltas.txt (or standard input) and after each one
+   writes the repaired route to standard output in the
+   format of output.txt, followed by an empty line.
+
+   main.exe --tree [trees.txt] reads "START GOAL1 GOAL2 ..."
+   lines and grows one shortest-path tree per line, writing
+   one line per goal and an empty line after each tree.
+   main.exe --matrix locations.txt reads a line of sources
+   and a line of targets and writes their cost matrix,
+   one row per source, -1 where there is no route.
+
+   main.exe --build-landmarks K graph.lmk picks K landmarks
+   and stores their cost tables next to the graph.
+   --landmarks graph.lmk loads them for the ALT algorithm,
+   A* with triangle-inequality bounds valid for any goal,
+   which falls back to UCS once an UPDATE changes a cost.
+
+   main.exe --build-ch graph.ch contracts the road network
+   into a contraction hierarchy. --ch graph.ch loads it for
+   the CH algorithm, which falls back to UCS once live
+   traffic costs differ from the contracted ones.
+
+   DELTA runs parallel delta-stepping on --threads N
+   threads with bucket width --delta W (default: mean
+   road cost). in batch mode the N threads answer
+   queries, so each DELTA query runs on one of them.
+
+   IDA* and IDDFS keep only the current path in memory.
+   --memory MB caps it; routes too long for the cap are
+   reported as no solution.
 */
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <vector>
 #include <deque>
-#include <stack>
 #include <map>
+#include <algorithm>
+#include <unordered_map>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <list>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <cctype>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
-string GOAL;
+// settings from the command line
+// set once in main before any search runs, only read afterwards
+struct Options {
+  int threads; // worker threads
+  int delta; // bucket width of delta-stepping, 0 picks the mean road cost
+  long long memory; // bytes IDA* and IDDFS may use for their path, 0 for no cap
+};
+
+Options OPTIONS = { 1, 0, 0 };
 
 // live traffic information
 // a and b are locations
@@ -49,358 +151,4137 @@ public:
   int c;
 };
 
-// keeps track of current location, path, and cost
-struct Node {
-  string state;
-  vector<string> path;
-  vector<int> costs;
-  int pathCost;
-  int totalCost;
+// header of binary graph file written by --convert
+// the file is a GraphHeader followed by, as 32-bit ints:
+// offsets[nodes + 1], targets[edges], weights[edges], heuristic[nodes],
+// nameoffs[nodes], sorted[nodes], then the string table of
+// nul-terminated location names padded to a multiple of 4 bytes
+struct GraphHeader {
+  char magic[8]; // "CSE512G"
+  int version;
+  int nodes;
+  int edges;
+  int strbytes;
 };
 
-// checks if node is in frontier queue
-bool inFrontier(Node n, deque<Node> q)
-{
-  Node t;
-  for(int i = 0; i < q.size(); i++)
-  {
-    t = q[i];
-    if(t.state == n.state)
-      return true;
+const char GRAPH_MAGIC[8] = "CSE512G";
+const int GRAPH_VERSION = 1;
+
+// cost of a location that has not been reached
+const int INF = INT_MAX / 4;
+
+// header of landmark file written by --build-landmarks
+// followed by, as 32-bit ints: ids[count], from[count * nodes], to[count * nodes]
+struct LandmarkHeader {
+  char magic[8]; // "CSE512L"
+  int version;
+  int count;
+  int nodes;
+  int edges;
+  unsigned long long checksum; // Graph::checksum of the roads it was built on
+};
+
+const char LANDMARK_MAGIC[8] = "CSE512L";
+const int LANDMARK_VERSION = 2;
+
+// estimate of remaining cost to a goal, plugged into best-first searches
+// a heuristic either keeps a table per goal indexed by location id, or
+// works out estimates one location at a time. estimates computed from
+// road costs only hold while Graph::version is still version
+class Heuristic {
+public:
+  Heuristic() {
+    version = -1;
   }
 
-  return false;
-}
+  virtual ~Heuristic() {}
 
-// checks if node is in frontier stack. used by DFS
-bool inStackFrontier(Node n, stack<Node> s)
-{
-  Node t;
-  for(int i = 0; i < s.size(); i++)
+  // estimates for goal indexed by location id, NULL if there is no table
+  virtual const int* table(int) const { return NULL; }
+
+  // estimate of cost from v to goal
+  virtual int estimate(int v, int goal) const = 0;
+
+  int version; // Graph::version the estimates were computed for
+};
+
+// landmark cost tables used by the ALT heuristic
+// from[i * nodes + v] is the cost from landmark i to v and
+// to[i * nodes + v] the cost from v to landmark i (INF if unreachable).
+// tables are only lower bounds for the road costs they were built on
+class Landmarks : public Heuristic {
+public:
+  Landmarks() {
+    count = 0;
+    nodes = 0;
+    edges = 0;
+    checksum = 0;
+  }
+
+  int estimate(int v, int goal) const { return bound(v, goal); }
+
+  // lower bound on cost from v to t by the triangle inequality:
+  // cost(v, t) >= cost(L, t) - cost(L, v) and cost(v, t) >= cost(v, L) - cost(t, L)
+  int bound(int v, int t) const
   {
-    t = s.top();
-    s.pop();
-    if(t.state == n.state)
-      return true;
+    int best = 0;
+    for(int i = 0; i < count; i++)
+    {
+      const int* f = &from[(long) i * nodes];
+      const int* r = &to[(long) i * nodes];
+      if(f[t] < INF && f[v] < INF)
+        best = max(best, f[t] - f[v]);
+      if(r[v] < INF && r[t] < INF)
+        best = max(best, r[v] - r[t]);
+    }
+
+    return best;
   }
 
-  return false;
-}
+  bool save(const char* file) const
+  {
+    ofstream out(file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!out.is_open())
+      return false;
 
-//checks if node has been explored
-bool inExplored(Node n, vector<Node>& v)
-{
-  Node t;
-  for(int i = 0; i < v.size(); i++)
+    LandmarkHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LANDMARK_MAGIC, 8);
+    h.version = LANDMARK_VERSION;
+    h.count = count;
+    h.nodes = nodes;
+    h.edges = edges;
+    h.checksum = checksum;
+
+    out.write((const char*) &h, sizeof(h));
+    out.write((const char*) ids.data(), 4L * count);
+    out.write((const char*) from.data(), 4L * count * nodes);
+    out.write((const char*) to.data(), 4L * count * nodes);
+
+    return out.good();
+  }
+
+  // reads landmark file written by save. returns false if the file
+  // cannot be read or was not built on a graph with n locations, m roads
+  // and Graph::checksum sum. tables of other road costs are no bounds
+  bool open(const char* file, int n, int m, unsigned long long sum)
   {
-    t = v[i];
-    if(t.state == n.state)
-      return true;
+    ifstream in(file, std::ifstream::in | std::ifstream::binary);
+    if(!in.is_open())
+      return false;
+
+    LandmarkHeader h;
+    in.read((char*) &h, sizeof(h));
+    if(!in || memcmp(h.magic, LANDMARK_MAGIC, 8) != 0 || h.version != LANDMARK_VERSION || h.nodes != n || h.edges != m || h.checksum != sum)
+      return false;
+
+    count = h.count;
+    nodes = h.nodes;
+    edges = h.edges;
+    checksum = h.checksum;
+    ids.resize(count);
+    from.resize((long) count * nodes);
+    to.resize((long) count * nodes);
+    in.read((char*) ids.data(), 4L * count);
+    in.read((char*) from.data(), 4L * count * nodes);
+    in.read((char*) to.data(), 4L * count * nodes);
+
+    return in.good();
   }
 
-  return false;
-}
+  int count;
+  int nodes; // size of graph tables were built for
+  int edges;
+  unsigned long long checksum; // Graph::checksum of the roads tables were built on
+  vector<int> ids; // location id of each landmark
+  vector<int> from;
+  vector<int> to;
+};
 
-// creates child nodes
-// child inherits path and costs from parent, then adds its own cost
-// bool b used by A* to add heuristic to total path cost 
-Node child_node(Node n, LiveRow lr, vector<SundayRow>& sr, bool b)
-{
-  Node child;
-  child.state = lr.b;
-  child.path = n.path;
-  child.path.push_back(child.state);
-  child.pathCost = n.pathCost + lr.c;
-  child.totalCost = child.pathCost;
-  child.costs = n.costs;
-  child.costs.push_back(child.pathCost);
+class Hierarchy;
+
+// road network built from live and Sunday traffic information
+// location names are interned to dense ids once at load time.
+// edges are stored in compressed sparse row form: out-edges of
+// location u are targets/weights[offsets[u]] to targets/weights[offsets[u+1]-1].
+// arrays are plain pointers so they can point either into vectors owned
+// by the graph (built from input.txt) or into a memory-mapped binary file
+class Graph {
+public:
+  Graph() {
+    nodes = 0;
+    edges = 0;
+    mapping = NULL;
+    maplen = 0;
+    roffsets = NULL;
+    rsources = NULL;
+    redges = NULL;
+    landmarks = NULL;
+    hierarchy = NULL;
+    goaltables = NULL;
+    version = 0;
+  }
 
-  if(b)
+  ~Graph()
   {
-    for(int i = 0; i < sr.size(); i++)
+    if(mapping != NULL)
+      munmap(mapping, maplen);
+  }
+
+  // returns id of location s[0..len), -1 if it has not been interned
+  int lookup(const char* s, int len) const
+  {
+    if(slots.empty())
+      return -1;
+
+    unsigned h = hash(s, len);
+    unsigned mask = slots.size() - 1;
+    for(unsigned i = h & mask; slots[i].id != -1; i = (i + 1) & mask)
     {
-      if(sr[i].a == child.state)
-        child.totalCost = sr[i].c + child.totalCost;
+      if(slots[i].hash != h)
+        continue;
+      const char* name = strdata.data() + slots[i].offset;
+      if(memcmp(name, s, len) == 0 && name[len] == '\0')
+        return slots[i].id;
     }
-  }
 
-  return child;
-}
+    return -1;
+  }
 
-// returns total path cost of child node. used by UCS and A*
-int child_totalCost(Node n, deque<Node> q)
-{
-  Node t;
-  for(int i = 0; i < q.size(); i++)
+  // returns id of location s[0..len), adding it if new. new names are
+  // copied straight into the string table. only used while loading
+  int intern(const char* s, int len)
   {
-    t = q[i];
-    if(t.state == n.state)
-      return t.totalCost;
-  }
+    int id = lookup(s, len);
+    if(id != -1)
+      return id;
 
-  return 0;
-}
+    id = nameoffdata.size();
+    nameoffdata.push_back(strdata.size());
+    strdata.insert(strdata.end(), s, s + len);
+    strdata.push_back('\0');
 
-// sorts frontier in ascending order by path cost. used by UCS and A*
-deque<Node> sortfrontier(Node n, deque<Node> q, vector<Node>& v)
-{
-  int i = 0;
-  deque<Node> f;
+    if(2 * nameoffdata.size() > slots.size())
+      rehash(max((size_t) 1024, 2 * slots.size()));
+    else
+      place(id, len);
+    return id;
+  }
 
-  if(n.totalCost < q[q.size()-1].totalCost)
+  int intern(const string& name) { return intern(name.data(), name.size()); }
+
+  // builds graph arrays from live traffic rows and Sunday heuristic rows
+  // out-edges keep the order they were given in input.txt
+  void build(vector<LiveRow>& lr, vector<SundayRow>& sr)
   {
-    while(inExplored(q[i], v))
+    vector<int> from(lr.size());
+    vector<int> to(lr.size());
+    vector<int> cost(lr.size());
+    for(int i = 0; i < lr.size(); i++)
     {
-      f.push_back(q[i]);
-      i++;
+      from[i] = intern(lr[i].a);
+      to[i] = intern(lr[i].b);
+      cost[i] = lr[i].c;
     }
 
-    while(n.totalCost >= q[i].totalCost && i < q.size())
+    vector<int> hid(sr.size());
+    vector<int> hcost(sr.size());
+    for(int i = 0; i < sr.size(); i++)
     {
-      f.push_back(q[i]);
-      i++;
+      hid[i] = lookup(sr[i].a.data(), sr[i].a.size());
+      hcost[i] = sr[i].c;
     }
-    f.push_back(n);
 
-    for(i; i < q.size(); i++)
-      f.push_back(q[i]);
-  } else {
-    q.push_back(n);
-    return q;
+    build(from, to, cost, hid, hcost);
   }
 
-  return f;
-}
+  // builds graph arrays from roads from[i] -> to[i] costing cost[i] over
+  // interned ids, and Sunday estimates hcost[i] of locations hid[i].
+  // hid of -1 is a location without roads and is skipped
+  void build(const vector<int>& from, const vector<int>& to, const vector<int>& cost, const vector<int>& hid, const vector<int>& hcost)
+  {
+    nodes = nameoffdata.size();
+    edges = from.size();
 
-// prints path and accumulated time from start to each location in output.txt
-void printout(Node n)
-{
-  ofstream ofs;
-  ofs.open("output.txt", std::ofstream::out | std::ofstream::trunc);
+    offsetdata.assign(nodes + 1, 0);
+    for(int i = 0; i < edges; i++)
+      offsetdata[from[i] + 1]++;
+    for(int i = 0; i < nodes; i++)
+      offsetdata[i + 1] += offsetdata[i];
 
-  for(int i = 0; i < n.path.size(); i++)
-    ofs << n.path[i] << " " << n.costs[i] << endl;
+    targetdata.resize(edges);
+    weightdata.resize(edges);
+    vector<int> next(offsetdata.begin(), offsetdata.end() - 1);
+    for(int i = 0; i < edges; i++)
+    {
+      int k = next[from[i]]++;
+      targetdata[k] = to[i];
+      weightdata[k] = cost[i];
+    }
 
-  ofs.close();
-}
+    // locations missing from the Sunday table get no heuristic.
+    // a location listed twice adds both estimates, as the old table scan did
+    heuristicdata.assign(nodes, 0);
+    for(int i = 0; i < hid.size(); i++)
+    {
+      if(hid[i] != -1)
+        heuristicdata[hid[i]] += hcost[i];
+    }
 
-// Breadth-first search
-void bfs(Node n, vector<LiveRow>& lr, vector<SundayRow>& sr)
-{
-  Node node = n;
-  node.costs.push_back(0);
-  deque<Node> frontier;
-  frontier.push_back(node);
-  vector<Node> explored;
-  int i = 0;
+    while(strdata.size() % 4 != 0)
+      strdata.push_back('\0');
+
+    sorteddata.resize(nodes);
+    for(int i = 0; i < nodes; i++)
+      sorteddata[i] = i;
+    sort(sorteddata.begin(), sorteddata.end(), NameOrder(*this));
+
+    // loading is done, lookups now go through find
+    slots.clear();
+    slots.shrink_to_fit();
+
+    offsets = offsetdata.data();
+    targets = targetdata.data();
+    weights = weightdata.data();
+    heuristic = heuristicdata.data();
+    nameoffs = nameoffdata.data();
+    sorted = sorteddata.data();
+    strings = strdata.data();
+    strbytes = strdata.size();
+  }
 
-  while(!frontier.empty())
+  // maps binary graph file written by save. returns false if the file
+  // cannot be read, is not a graph file or its tables do not form a graph
+  bool open(const char* file)
   {
-    node = frontier[i];
-    if(node.state == GOAL)
+    int fd = ::open(file, O_RDONLY);
+    if(fd == -1)
+      return false;
+
+    struct stat st;
+    if(fstat(fd, &st) == -1 || st.st_size < sizeof(GraphHeader))
     {
-      printout(node);
-      return;
+      close(fd);
+      return false;
     }
-    explored.push_back(node);
 
-    for(int i = 0; i < lr.size(); i++)
+    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+      return false;
+
+    const GraphHeader* h = (const GraphHeader*) p;
+    long expected = sizeof(GraphHeader) + 4L * ((long) h->nodes * 4 + 1 + (long) h->edges * 2) + h->strbytes;
+    if(memcmp(h->magic, GRAPH_MAGIC, 8) != 0 || h->version != GRAPH_VERSION || h->nodes < 0 || h->edges < 0
+      || h->strbytes < 0 || expected != st.st_size || !wellformed(h))
     {
-      if(lr[i].a == node.state)
-      {
-        Node child = child_node(node, lr[i], sr, false);
-        if(!inFrontier(child, frontier) && !inExplored(child, explored))
-          frontier.push_back(child);
-      }
+      munmap(p, st.st_size);
+      return false;
     }
 
-    i++;
+    mapping = p;
+    maplen = st.st_size;
+    nodes = h->nodes;
+    edges = h->edges;
+    strbytes = h->strbytes;
+    offsets = (const int*) (h + 1);
+    targets = offsets + nodes + 1;
+    weights = targets + edges;
+    heuristic = weights + edges;
+    nameoffs = heuristic + nodes;
+    sorted = nameoffs + nodes;
+    strings = (const char*) (sorted + nodes);
+
+    return true;
   }
 
-  cout << "No solution \n";
-}
+  // writes graph in binary format read by open
+  bool save(const char* file) const
+  {
+    ofstream out(file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!out.is_open())
+      return false;
 
-// Depth-first search
-void dfs(Node n, vector<LiveRow>& lr, vector<SundayRow>& sr)
-{
-  Node node = n;
-  node.costs.push_back(0);
-  stack<Node> frontier;
-  frontier.push(node);
-  vector<Node> explored;
+    GraphHeader h;
+    memcpy(h.magic, GRAPH_MAGIC, 8);
+    h.version = GRAPH_VERSION;
+    h.nodes = nodes;
+    h.edges = edges;
+    h.strbytes = strbytes;
 
-  while(!frontier.empty())
+    out.write((const char*) &h, sizeof(h));
+    out.write((const char*) offsets, 4L * (nodes + 1));
+    out.write((const char*) targets, 4L * edges);
+    out.write((const char*) weights, 4L * edges);
+    out.write((const char*) heuristic, 4L * nodes);
+    out.write((const char*) nameoffs, 4L * nodes);
+    out.write((const char*) sorted, 4L * nodes);
+    out.write(strings, strbytes);
+
+    return out.good();
+  }
+
+  // returns id of location or -1 if location is unknown
+  // binary search over ids sorted by name
+  int find(const string& name) const
   {
-    node = frontier.top();
-    frontier.pop();
-    if(node.state == GOAL)
+    int lo = 0;
+    int hi = nodes;
+    while(lo < hi)
     {
-      printout(node);
-      return;
+      int mid = (lo + hi) / 2;
+      int c = strcmp(this->name(sorted[mid]), name.c_str());
+      if(c == 0)
+        return sorted[mid];
+      if(c < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
     }
-    explored.push_back(node);
 
-    for(int i = 0; i < lr.size(); i++)
+    return -1;
+  }
+
+  // builds in-edge arrays used by searches that walk roads backwards
+  // in-edges of location v are rsources/redges[roffsets[v]] to
+  // rsources/redges[roffsets[v+1]-1]. redges holds the forward edge index.
+  // only searches that need them call this, the first call builds them.
+  // batch threads may call it at once. road cost changes keep them valid
+  void buildreverse()
+  {
+    call_once(reversed, &Graph::makereverse, this);
+  }
+
+  // returns first edge from a to b, or -1 if there is no such road
+  int findedge(int a, int b) const
+  {
+    for(int e = offsets[a]; e < offsets[a + 1]; e++)
+    {
+      if(targets[e] == b)
+        return e;
+    }
+
+    return -1;
+  }
+
+  // changes time/cost of edge e. a mapped graph gets a private copy of
+  // its weights on the first change, the file itself is never written
+  void setweight(int e, int c)
+  {
+    if(weightdata.size() != edges)
+      weightdata.assign(weights, weights + edges);
+    weightdata[e] = c;
+    weights = weightdata.data();
+    version++;
+  }
+
+  // hash of roads and their costs, used to check that preprocessed
+  // data was built for this graph
+  unsigned long long checksum() const
+  {
+    unsigned long long h = 14695981039346656037ULL;
+    const int* arrays[3] = { offsets, targets, weights };
+    int sizes[3] = { nodes + 1, edges, edges };
+    for(int a = 0; a < 3; a++)
     {
-      if(lr[i].a == node.state)
+      for(int i = 0; i < sizes[a]; i++)
       {
-        Node child = child_node(node, lr[i], sr, false);
-        if(!inStackFrontier(child, frontier) && !inExplored(child, explored))
-          frontier.push(child);
+        h ^= (unsigned) arrays[a][i];
+        h *= 1099511628211ULL;
       }
     }
+
+    return h;
   }
 
-  cout << "No solution \n";
-}
+  const char* name(int id) const { return strings + nameoffs[id]; }
+  int size() const { return nodes; }
 
-// Uniform cost search
-void ucs(Node n, vector<LiveRow>& lr, vector<SundayRow>& sr)
-{
-  Node node = n;
-  node.costs.push_back(0);
-  deque<Node> frontier;
-  frontier.push_back(node);
-  vector<Node> explored;
-  int i = 0;
+  int nodes;
+  int edges;
+  const int* offsets; // first out-edge of each location, plus one past the last edge
+  const int* targets; // location each edge leads to
+  const int* weights; // time/cost of each edge
+  const int* heuristic; // Sunday estimate from each location to goal
+  const int* nameoffs; // start of each location name in strings
+  const int* sorted; // location ids sorted by name, used by find
+  const char* strings; // nul-terminated location names
+  int strbytes;
+  const int* roffsets; // first in-edge of each location, NULL until buildreverse
+  const int* rsources; // location each in-edge comes from
+  const int* redges; // forward edge index of each in-edge
+  const Landmarks* landmarks; // ALT tables, NULL unless loaded
+  const Hierarchy* hierarchy; // contraction hierarchy, NULL unless loaded
+  const Heuristic* goaltables; // Sunday tables of other goals, NULL unless loaded
+  int version; // bumped on every road cost change
 
-  while(!frontier.empty())
+  // replaces the Sunday table, one estimate per location id
+  void setheuristic(const vector<int>& h)
   {
-    node = frontier[i];
-    if(node.state == GOAL)
+    heuristicdata = h;
+    heuristic = heuristicdata.data();
+  }
+
+private:
+  // checks the tables following header h of a mapped file: offsets
+  // start at 0, never decrease and end at edges, roads lead to
+  // locations and cost no less than 0, names lie in the string table
+  static bool wellformed(const GraphHeader* h)
+  {
+    int n = h->nodes;
+    int m = h->edges;
+    const int* offsets = (const int*) (h + 1);
+    const int* targets = offsets + n + 1;
+    const int* weights = targets + m;
+    const int* nameoffs = weights + m + n;
+    const int* sorted = nameoffs + n;
+    const char* strings = (const char*) (sorted + n);
+
+    if(offsets[0] != 0 || offsets[n] != m)
+      return false;
+    for(int u = 0; u < n; u++)
     {
-      printout(node);
-      return;
+      if(offsets[u + 1] < offsets[u])
+        return false;
+    }
+    for(int e = 0; e < m; e++)
+    {
+      if(targets[e] < 0 || targets[e] >= n || weights[e] < 0)
+        return false;
+    }
+    if(n > 0 && (h->strbytes == 0 || strings[h->strbytes - 1] != '\0'))
+      return false;
+    for(int u = 0; u < n; u++)
+    {
+      if(nameoffs[u] < 0 || nameoffs[u] >= h->strbytes || sorted[u] < 0 || sorted[u] >= n)
+        return false;
     }
-    explored.push_back(node);
+    return true;
+  }
 
-    for(int i = 0; i < lr.size(); i++)
+  // fills the in-edge arrays, called once through buildreverse
+  void makereverse()
+  {
+    roffsetdata.assign(nodes + 1, 0);
+    for(int e = 0; e < edges; e++)
+      roffsetdata[targets[e] + 1]++;
+    for(int i = 0; i < nodes; i++)
+      roffsetdata[i + 1] += roffsetdata[i];
+
+    rsourcedata.resize(edges);
+    redgedata.resize(edges);
+    vector<int> next(roffsetdata.begin(), roffsetdata.end() - 1);
+    for(int u = 0; u < nodes; u++)
     {
-      if(lr[i].a == node.state)
+      for(int e = offsets[u]; e < offsets[u + 1]; e++)
       {
-        Node child = child_node(node, lr[i], sr, false);
-        if(!inFrontier(child, frontier) && !inExplored(child, explored))
-          frontier = sortfrontier(child, frontier, explored);
-        else if(inFrontier(child, frontier) && (child.totalCost < child_totalCost(child, frontier)))
-          frontier = sortfrontier(child, frontier, explored);
+        int k = next[targets[e]]++;
+        rsourcedata[k] = u;
+        redgedata[k] = e;
       }
     }
 
-    i++;
+    roffsets = roffsetdata.data();
+    rsources = rsourcedata.data();
+    redges = redgedata.data();
   }
 
-  cout << "No solution \n";
-}
+  // orders location ids by name while building
+  struct NameOrder {
+    NameOrder(Graph& g) : g(g) {}
+    bool operator()(int a, int b) const
+    {
+      return strcmp(g.strdata.data() + g.nameoffdata[a], g.strdata.data() + g.nameoffdata[b]) < 0;
+    }
+    Graph& g;
+  };
 
-// A* search
-void astar(Node n, vector<LiveRow>& lr, vector<SundayRow>& sr)
-{
-  Node node = n;
-  node.costs.push_back(0);
-  deque<Node> frontier;
-  frontier.push_back(node);
-  vector<Node> explored;
-  int i = 0;
+  // FNV-1a hash of a location name
+  static unsigned hash(const char* s, int len)
+  {
+    unsigned h = 2166136261u;
+    for(int i = 0; i < len; i++)
+      h = (h ^ (unsigned char) s[i]) * 16777619u;
+    return h;
+  }
+
+  // slot of the intern table. hash and offset of the name are kept
+  // next to the id so most probes never touch the string table
+  struct Slot {
+    unsigned hash;
+    int id; // -1 for a free slot
+    int offset; // of the name in the string table
+  };
+
+  // puts id of a name of length len in the first free slot of its chain
+  void place(int id, int len)
+  {
+    Slot slot = { hash(strdata.data() + nameoffdata[id], len), id, nameoffdata[id] };
+    unsigned mask = slots.size() - 1;
+    unsigned i = slot.hash & mask;
+    while(slots[i].id != -1)
+      i = (i + 1) & mask;
+    slots[i] = slot;
+  }
+
+  // grows the table to size slots (a power of two) and refills it
+  void rehash(size_t size)
+  {
+    Slot free = { 0, -1, 0 };
+    slots.assign(size, free);
+    for(int id = 0; id < nameoffdata.size(); id++)
+      place(id, strlen(strdata.data() + nameoffdata[id]));
+  }
+
+  // open-addressing table of interned names, only used while loading
+  vector<Slot> slots;
 
-  while(!frontier.empty())
+  // storage for graphs built from input.txt
+  vector<int> offsetdata;
+  vector<int> targetdata;
+  vector<int> weightdata;
+  vector<int> heuristicdata;
+  vector<int> nameoffdata;
+  vector<int> sorteddata;
+  vector<char> strdata;
+  vector<int> roffsetdata;
+  vector<int> rsourcedata;
+  vector<int> redgedata;
+  once_flag reversed;
+
+  // mapping for graphs opened from a binary file
+  void* mapping;
+  size_t maplen;
+};
+
+// keeps track of current location and cost
+// path is not copied into each node. it is rebuilt by following
+// parent links back to the start node
+struct Node {
+  int state;
+  int pathCost;
+  int totalCost;
+  int parent; // pool index of parent node, -1 for start node
+};
+
+// arena holding every node generated by a search
+// nodes refer to each other by index. reset keeps the memory so
+// steady state searches allocate nothing
+class NodePool {
+public:
+  void reset() { nodes.clear(); }
+
+  // adds node and returns its index
+  int add(Node& n)
+  {
+    nodes.push_back(n);
+    return nodes.size() - 1;
+  }
+
+  Node& operator[](int i) { return nodes[i]; }
+
+  vector<Node> nodes;
+};
+
+// set of location ids with constant time insert, erase and lookup
+// used to track which locations are in a frontier or explored.
+// reset bumps a generation number instead of clearing every slot
+class StateSet {
+public:
+  StateSet() {
+    gen = 0;
+  }
+
+  // empties set for a graph with n locations
+  void reset(int n)
   {
-    node = frontier[i];
-    if(node.state == GOAL)
+    if(mark.size() != n)
+      mark.assign(n, 0);
+    gen++;
+    if(gen == 0) // generation wrapped around, old marks could match again
     {
-      printout(node);
-      return;
+      mark.assign(n, 0);
+      gen = 1;
     }
-    explored.push_back(node);
+  }
 
-    for(int i = 0; i < lr.size(); i++)
+  bool contains(int state) const { return mark[state] == gen; }
+  void insert(int state) { mark[state] = gen; }
+  void erase(int state) { mark[state] = 0; }
+  long long bytes() const { return mark.capacity() * sizeof(unsigned); }
+
+  vector<unsigned> mark; // generation each location was last inserted in
+  unsigned gen;
+};
+
+// cost, parent and parent edge of each location with O(1) reset
+// unset locations cost INF. uses the same generation trick as StateSet
+class CostTable {
+public:
+  CostTable() {
+    gen = 0;
+  }
+
+  // clears table for a graph with n locations
+  void reset(int n)
+  {
+    if(mark.size() != n)
     {
-      if(lr[i].a == node.state)
-      {
-        Node child = child_node(node, lr[i], sr, true);
-        if(!inFrontier(child, frontier) && !inExplored(child, explored))
-          frontier = sortfrontier(child, frontier, explored);
-        else if(inFrontier(child, frontier) && (child.totalCost < child_totalCost(child, frontier)))
-          frontier = sortfrontier(child, frontier, explored);
-      }
+      mark.assign(n, 0);
+      costs.resize(n);
+      parents.resize(n);
+      vias.resize(n);
+    }
+    gen++;
+    if(gen == 0)
+    {
+      mark.assign(n, 0);
+      gen = 1;
     }
+  }
+
+  int cost(int state) const { return mark[state] == gen ? costs[state] : INF; }
+  int parent(int state) const { return parents[state]; }
+  int via(int state) const { return vias[state]; }
+
+  long long bytes() const { return (mark.capacity() + costs.capacity() + parents.capacity() + vias.capacity()) * sizeof(int); }
+
+  void set(int state, int cost, int parent, int via)
+  {
+    mark[state] = gen;
+    costs[state] = cost;
+    parents[state] = parent;
+    vias[state] = via;
+  }
+
+  vector<unsigned> mark;
+  vector<int> costs;
+  vector<int> parents; // location the cost was reached from
+  vector<int> vias; // edge or arc used to get there
+  unsigned gen;
+};
+
+// estimate of remaining cost added to path cost by best-first search
+const int H_NONE = 0; // UCS
+const int H_SUNDAY = 1; // Sunday table of the goal, input.txt's only valid for its goal
+const int H_LANDMARK = 2; // ALT lower bounds, valid for any goal
+
+// heuristic of one query, resolved before the search starts so that
+// generating a child costs one array read whenever there is a table
+struct Estimate {
+  const int* table;
+  const Heuristic* source; // asked per location when there is no table
+  int goal;
 
-    i++;
+  int operator()(int v) const
+  {
+    if(table != NULL)
+      return table[v];
+    return source != NULL ? source->estimate(v, goal) : 0;
   }
+};
 
-  cout << "No solution \n";
+// resolves heuristic h for goal. H_SUNDAY uses the goal's own table when
+// --heuristics loaded one, else the Sunday table of input.txt.
+// H_LANDMARK asks the landmarks, if loaded, per location. tables built
+// on road costs that an UPDATE has since changed are not used
+Estimate estimator(Graph& g, int h, int goal)
+{
+  Estimate est = { NULL, NULL, goal };
+  if(h == H_SUNDAY)
+  {
+    if(g.goaltables != NULL && g.goaltables->version == g.version)
+      est.table = g.goaltables->table(goal);
+    if(est.table == NULL)
+      est.table = g.heuristic;
+  }
+  else if(h == H_LANDMARK && g.landmarks != NULL && g.landmarks->version == g.version)
+    est.source = g.landmarks;
+  return est;
 }
 
-int main()
+// creates child nodes in pool and returns index
+// child links to parent, then adds its own cost
+// e is the edge of g leading from parent to child
+// est is the heuristic added to total path cost
+int child_node(int n, NodePool& pool, Graph& g, int e, const Estimate& est)
 {
-  fstream in;
-  string alg;
-  int a;
-  string start;
-  int lines;
-  string info;
-  int cost;
-  vector<LiveRow> liverow;
-  vector<SundayRow> sundayrow;
+  Node child;
+  child.state = g.targets[e];
+  child.parent = n;
+  child.pathCost = pool[n].pathCost + g.weights[e];
+  child.totalCost = est(child.state) + child.pathCost;
+
+  return pool.add(child);
+}
+
+// frontier used by UCS and A*
+// binary min-heap ordered by total path cost. pos holds the heap slot of
+// each location in the frontier (-1 if absent) so a cheaper path to a
+// location already in the frontier can lower its key in place.
+// ties leave in the order they were added, like the old sorted deque
+class Frontier {
+public:
+  // empties frontier for a graph with n locations
+  void reset(int n)
+  {
+    if(pos.size() != n)
+      pos.assign(n, -1);
+    else
+    {
+      // popped nodes already cleared their slot, only clear what is left
+      for(int i = 0; i < heap.size(); i++)
+        pos[heap[i].state] = -1;
+    }
+    heap.clear();
+    count = 0;
+  }
 
-  in.open("input.txt");
+  bool empty() const { return heap.empty(); }
+  int size() const { return heap.size(); }
+  long long bytes() const { return heap.capacity() * sizeof(Entry) + pos.capacity() * sizeof(int); }
+  bool contains(int state) const { return pos[state] != -1; }
 
-  in >> alg;
-  in >> start;
-  in >> GOAL;
-  in >> lines;
+  // returns total path cost of location in frontier
+  int totalCost(int state) const { return heap[pos[state]].totalCost; }
 
-  for(int i = 0; i < lines; i++)
+  // adds pool node n
+  void push(int n, NodePool& pool)
   {
-    LiveRow l;
-    in >> info;
-    l.a = info;
-    in >> info;
-    l.b = info;
-    in >> cost;
-    l.c = cost;
-    liverow.push_back(l);
+    Entry e;
+    e.node = n;
+    e.state = pool[n].state;
+    e.totalCost = pool[n].totalCost;
+    e.order = count++;
+    heap.push_back(e);
+    pos[e.state] = heap.size() - 1;
+    up(heap.size() - 1);
   }
 
-  in >> lines;
+  // replaces frontier node with the same location by cheaper pool node n
+  void decrease(int n, NodePool& pool)
+  {
+    int i = pos[pool[n].state];
+    heap[i].node = n;
+    heap[i].totalCost = pool[n].totalCost;
+    heap[i].order = count++;
+    up(i);
+  }
 
-  for(int i = 0; i < lines; i++)
+  // removes and returns pool index of node with lowest total path cost
+  int pop()
   {
-    SundayRow s;
-    in >> info;
-    s.a = info;
-    in >> cost;
-    s.c = cost;
-    sundayrow.push_back(s);
+    int n = heap[0].node;
+    pos[heap[0].state] = -1;
+    if(heap.size() > 1)
+    {
+      heap[0] = heap.back();
+      pos[heap[0].state] = 0;
+    }
+    heap.pop_back();
+    if(!heap.empty())
+      down(0);
+    return n;
   }
 
-  in.close();
+private:
+  struct Entry {
+    int node; // pool index
+    int state;
+    int totalCost;
+    unsigned long order; // insertion count, breaks ties
+  };
 
-  Node node;
-  node.state = start;
-  node.path.push_back(start);
-  node.pathCost = 0;
-  node.totalCost = 0;
+  bool less(int i, int j) const
+  {
+    if(heap[i].totalCost != heap[j].totalCost)
+      return heap[i].totalCost < heap[j].totalCost;
+    return heap[i].order < heap[j].order;
+  }
 
-  map<string, int> algorithms = { {"BFS", 0}, {"DFS", 1}, {"UCS", 2}, {"A*", 3} };
-  a = algorithms[alg];
+  void swapentries(int i, int j)
+  {
+    swap(heap[i], heap[j]);
+    pos[heap[i].state] = i;
+    pos[heap[j].state] = j;
+  }
 
-  switch(a)
+  void up(int i)
   {
-    case 0:
-      bfs(node, liverow, sundayrow);
-      break;
-    case 1:
-      dfs(node, liverow, sundayrow);
-      break;
-    case 2:
-      ucs(node, liverow, sundayrow);
-      break;
-    case 3:
-      astar(node, liverow, sundayrow);
-      break;
-    default:
-      break;
+    while(i > 0 && less(i, (i - 1) / 2))
+    {
+      swapentries(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
   }
 
+  void down(int i)
+  {
+    while(true)
+    {
+      int l = 2 * i + 1;
+      int r = l + 1;
+      int m = i;
+      if(l < heap.size() && less(l, m))
+        m = l;
+      if(r < heap.size() && less(r, m))
+        m = r;
+      if(m == i)
+        return;
+      swapentries(i, m);
+      i = m;
+    }
+  }
+
+  vector<Entry> heap;
+  vector<int> pos;
+  unsigned long count;
+};
+
+// indexed binary min-heap of locations keyed by a 64-bit priority
+// pos holds the heap slot of each location (-1 if absent) so a key can
+// be changed or a location removed in O(log n). used by searches that
+// keep one entry per location and no node pool
+class KeyHeap {
+public:
+  // empties heap for a graph with n locations
+  void reset(int n)
+  {
+    if(pos.size() != n)
+      pos.assign(n, -1);
+    else
+    {
+      // popped locations already cleared their slot, only clear what is left
+      for(int i = 0; i < heap.size(); i++)
+        pos[heap[i].state] = -1;
+    }
+    heap.clear();
+  }
+
+  bool empty() const { return heap.empty(); }
+  int size() const { return heap.size(); }
+  long long bytes() const { return heap.capacity() * sizeof(Entry) + pos.capacity() * sizeof(int); }
+  bool contains(int state) const { return pos[state] != -1; }
+  int top() const { return heap[0].state; }
+  int at(int i) const { return heap[i].state; } // location in heap slot i
+  long long topkey() const { return heap[0].key; }
+
+  // adds location, or changes its key if already in heap
+  void push(int state, long long key)
+  {
+    int i = pos[state];
+    if(i == -1)
+    {
+      Entry e;
+      e.state = state;
+      e.key = key;
+      heap.push_back(e);
+      pos[state] = heap.size() - 1;
+      up(heap.size() - 1);
+      return;
+    }
+
+    long long old = heap[i].key;
+    heap[i].key = key;
+    if(key < old)
+      up(i);
+    else
+      down(i);
+  }
+
+  // removes and returns location with lowest key
+  int pop()
+  {
+    int state = heap[0].state;
+    remove(state);
+    return state;
+  }
+
+  void remove(int state)
+  {
+    int i = pos[state];
+    pos[state] = -1;
+    if(i != heap.size() - 1)
+    {
+      int moved = heap.back().state;
+      heap[i] = heap.back();
+      pos[moved] = i;
+      heap.pop_back();
+      up(i);
+      down(pos[moved]);
+    }
+    else
+      heap.pop_back();
+  }
+
+private:
+  struct Entry {
+    int state;
+    long long key;
+  };
+
+  void swapentries(int i, int j)
+  {
+    swap(heap[i], heap[j]);
+    pos[heap[i].state] = i;
+    pos[heap[j].state] = j;
+  }
+
+  void up(int i)
+  {
+    while(i > 0 && heap[i].key < heap[(i - 1) / 2].key)
+    {
+      swapentries(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void down(int i)
+  {
+    while(true)
+    {
+      int l = 2 * i + 1;
+      int r = l + 1;
+      int m = i;
+      if(l < heap.size() && heap[l].key < heap[m].key)
+        m = l;
+      if(r < heap.size() && heap[r].key < heap[m].key)
+        m = r;
+      if(m == i)
+        return;
+      swapentries(i, m);
+      i = m;
+    }
+  }
+
+  vector<Entry> heap;
+  vector<int> pos;
+};
+
+// costs from s to every location, or from every location to s if
+// backward, written to dist. plain Dijkstra used for preprocessing
+void shortestcosts(Graph& g, int s, bool backward, int* dist, KeyHeap& heap)
+{
+  if(backward)
+    g.buildreverse();
+  for(int i = 0; i < g.size(); i++)
+    dist[i] = INF;
+  heap.reset(g.size());
+  dist[s] = 0;
+  heap.push(s, 0);
+
+  while(!heap.empty())
+  {
+    int u = heap.pop();
+    int first = backward ? g.roffsets[u] : g.offsets[u];
+    int last = backward ? g.roffsets[u + 1] : g.offsets[u + 1];
+    for(int k = first; k < last; k++)
+    {
+      int v = backward ? g.rsources[k] : g.targets[k];
+      int c = dist[u] + g.weights[backward ? g.redges[k] : k];
+      if(c < dist[v])
+      {
+        dist[v] = c;
+        heap.push(v, c);
+      }
+    }
+  }
+}
+
+// picks k landmarks and fills their cost tables
+// landmarks are chosen farthest-first: each new landmark is the location
+// whose cost from the nearest chosen landmark is largest, with unreached
+// locations counted as farthest so every part of the graph gets covered
+void buildlandmarks(Graph& g, int k, Landmarks& lm)
+{
+  g.buildreverse();
+  int n = g.size();
+  KeyHeap heap;
+  vector<int> nearest(n, INF);
+  vector<int> dist(n);
+
+  lm.count = 0;
+  lm.nodes = n;
+  lm.edges = g.edges;
+  lm.checksum = g.checksum();
+  lm.version = g.version;
+  lm.ids.clear();
+  lm.from.clear();
+  lm.to.clear();
+  if(n == 0)
+    return;
+
+  // first landmark is the location farthest from location 0
+  shortestcosts(g, 0, false, dist.data(), heap);
+  int next = 0;
+  for(int v = 0; v < n; v++)
+  {
+    if(dist[v] < INF && dist[v] > dist[next])
+      next = v;
+  }
+
+  while(lm.count < k && lm.count < n)
+  {
+    lm.ids.push_back(next);
+    lm.from.resize((long) (lm.count + 1) * n);
+    lm.to.resize((long) (lm.count + 1) * n);
+    shortestcosts(g, next, false, &lm.from[(long) lm.count * n], heap);
+    shortestcosts(g, next, true, &lm.to[(long) lm.count * n], heap);
+    lm.count++;
+
+    const int* f = &lm.from[(long) (lm.count - 1) * n];
+    for(int v = 0; v < n; v++)
+      nearest[v] = min(nearest[v], f[v]);
+    nearest[next] = -1;
+
+    next = 0;
+    for(int v = 0; v < n; v++)
+    {
+      if(nearest[v] > nearest[next])
+        next = v;
+    }
+    if(nearest[next] == -1) // every location is a landmark
+      break;
+  }
+}
+
+// header of contraction hierarchy file written by --build-ch
+// followed by, as 32-bit ints: rank[nodes], upoffsets[nodes + 1],
+// uptargets[uparcs], upweights[uparcs], upmids[uparcs],
+// downoffsets[nodes + 1], downsources[downarcs], downweights[downarcs],
+// downmids[downarcs]
+struct HierarchyHeader {
+  char magic[8]; // "CSE512C"
+  int version;
+  int nodes;
+  int edges;
+  int uparcs;
+  int downarcs;
+  unsigned long long checksum; // Graph::checksum of the roads it was built on
+};
+
+const char HIERARCHY_MAGIC[8] = "CSE512C";
+const int HIERARCHY_VERSION = 1;
+
+// contraction hierarchy over the road network
+// locations are contracted one at a time in order of rank. contracting v
+// adds a shortcut u->x with mid v for every u->v->x that no witness path
+// avoiding v can match, so shortest paths only ever need to climb to
+// higher ranks and come back down. arcs to higher ranked locations are
+// kept with their tail as up arcs, arcs from higher ranked locations
+// with their head as down arcs. mid is -1 for an original road
+class Hierarchy {
+public:
+  Hierarchy() {
+    nodes = 0;
+    edges = 0;
+    checksum = 0;
+    version = -1;
+  }
+
+  // contracts every location of g
+  void build(Graph& g)
+  {
+    int n = g.size();
+    nodes = n;
+    edges = g.edges;
+    checksum = g.checksum();
+    version = g.version;
+
+    out.assign(n, vector<Arc>());
+    in.assign(n, vector<Arc>());
+    for(int u = 0; u < n; u++)
+    {
+      for(int e = g.offsets[u]; e < g.offsets[u + 1]; e++)
+        addarc(u, g.targets[e], g.weights[e], -1);
+    }
+
+    done.assign(n, 0);
+    deleted.assign(n, 0);
+    rank.assign(n, 0);
+    wheap.reset(n);
+    wcost.reset(n);
+
+    // lazy updates: a popped location is contracted only if its
+    // recomputed priority still beats the rest of the queue
+    KeyHeap order;
+    order.reset(n);
+    for(int v = 0; v < n; v++)
+      order.push(v, priority(v));
+
+    int r = 0;
+    while(!order.empty())
+    {
+      int v = order.pop();
+      long long p = priority(v);
+      if(!order.empty() && p > order.topkey())
+      {
+        order.push(v, p);
+        continue;
+      }
+
+      contract(v, true);
+      done[v] = 1;
+      rank[v] = r++;
+
+      for(int i = 0; i < out[v].size(); i++)
+      {
+        int x = out[v][i].node;
+        if(!done[x])
+        {
+          deleted[x]++;
+          order.push(x, priority(x));
+        }
+      }
+      for(int i = 0; i < in[v].size(); i++)
+      {
+        int x = in[v][i].node;
+        if(!done[x])
+        {
+          deleted[x]++;
+          order.push(x, priority(x));
+        }
+      }
+    }
+
+    // split arcs into up and down arrays
+    upoffsets.assign(n + 1, 0);
+    downoffsets.assign(n + 1, 0);
+    for(int u = 0; u < n; u++)
+    {
+      for(int i = 0; i < out[u].size(); i++)
+      {
+        if(rank[out[u][i].node] > rank[u])
+          upoffsets[u + 1]++;
+        else
+          downoffsets[out[u][i].node + 1]++;
+      }
+    }
+    for(int i = 0; i < n; i++)
+    {
+      upoffsets[i + 1] += upoffsets[i];
+      downoffsets[i + 1] += downoffsets[i];
+    }
+
+    uptargets.resize(upoffsets[n]);
+    upweights.resize(upoffsets[n]);
+    upmids.resize(upoffsets[n]);
+    downsources.resize(downoffsets[n]);
+    downweights.resize(downoffsets[n]);
+    downmids.resize(downoffsets[n]);
+    vector<int> upnext(upoffsets.begin(), upoffsets.end() - 1);
+    vector<int> downnext(downoffsets.begin(), downoffsets.end() - 1);
+    for(int u = 0; u < n; u++)
+    {
+      for(int i = 0; i < out[u].size(); i++)
+      {
+        Arc& a = out[u][i];
+        if(rank[a.node] > rank[u])
+        {
+          int k = upnext[u]++;
+          uptargets[k] = a.node;
+          upweights[k] = a.w;
+          upmids[k] = a.mid;
+        } else {
+          int k = downnext[a.node]++;
+          downsources[k] = u;
+          downweights[k] = a.w;
+          downmids[k] = a.mid;
+        }
+      }
+    }
+
+    out.clear();
+    in.clear();
+  }
+
+  // writes hierarchy in binary format read by open
+  bool save(const char* file) const
+  {
+    ofstream os(file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!os.is_open())
+      return false;
+
+    HierarchyHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, HIERARCHY_MAGIC, 8);
+    h.version = HIERARCHY_VERSION;
+    h.nodes = nodes;
+    h.edges = edges;
+    h.uparcs = uptargets.size();
+    h.downarcs = downsources.size();
+    h.checksum = checksum;
+
+    os.write((const char*) &h, sizeof(h));
+    os.write((const char*) rank.data(), 4L * nodes);
+    os.write((const char*) upoffsets.data(), 4L * (nodes + 1));
+    os.write((const char*) uptargets.data(), 4L * h.uparcs);
+    os.write((const char*) upweights.data(), 4L * h.uparcs);
+    os.write((const char*) upmids.data(), 4L * h.uparcs);
+    os.write((const char*) downoffsets.data(), 4L * (nodes + 1));
+    os.write((const char*) downsources.data(), 4L * h.downarcs);
+    os.write((const char*) downweights.data(), 4L * h.downarcs);
+    os.write((const char*) downmids.data(), 4L * h.downarcs);
+
+    return os.good();
+  }
+
+  // reads hierarchy file written by save. returns false if the file cannot
+  // be read or was built on other roads or costs than those of g
+  bool open(const char* file, Graph& g)
+  {
+    ifstream is(file, std::ifstream::in | std::ifstream::binary);
+    if(!is.is_open())
+      return false;
+
+    HierarchyHeader h;
+    is.read((char*) &h, sizeof(h));
+    if(!is || memcmp(h.magic, HIERARCHY_MAGIC, 8) != 0 || h.version != HIERARCHY_VERSION || h.nodes != g.size() || h.edges != g.edges || h.checksum != g.checksum())
+      return false;
+
+    nodes = h.nodes;
+    edges = h.edges;
+    checksum = h.checksum;
+    version = g.version;
+    readints(is, rank, nodes);
+    readints(is, upoffsets, nodes + 1);
+    readints(is, uptargets, h.uparcs);
+    readints(is, upweights, h.uparcs);
+    readints(is, upmids, h.uparcs);
+    readints(is, downoffsets, nodes + 1);
+    readints(is, downsources, h.downarcs);
+    readints(is, downweights, h.downarcs);
+    readints(is, downmids, h.downarcs);
+
+    return is.good();
+  }
+
+  // appends the roads that arc u->v of cost w with middle location mid
+  // stands for to steps, as (location reached, road cost) pairs
+  void unpack(int u, int v, int w, int mid, vector<int>& steps) const
+  {
+    if(mid == -1)
+    {
+      steps.push_back(v);
+      steps.push_back(w);
+      return;
+    }
+
+    // mid was contracted before u and v, so u->mid is a down arc of mid
+    // and mid->v an up arc of mid
+    for(int k = downoffsets[mid]; k < downoffsets[mid + 1]; k++)
+    {
+      if(downsources[k] == u)
+      {
+        unpack(u, mid, downweights[k], downmids[k], steps);
+        break;
+      }
+    }
+    for(int k = upoffsets[mid]; k < upoffsets[mid + 1]; k++)
+    {
+      if(uptargets[k] == v)
+      {
+        unpack(mid, v, upweights[k], upmids[k], steps);
+        break;
+      }
+    }
+  }
+
+  int nodes;
+  int edges;
+  unsigned long long checksum;
+  int version; // Graph::version the hierarchy matches
+  vector<int> rank; // contraction order of each location
+  vector<int> upoffsets;
+  vector<int> uptargets;
+  vector<int> upweights;
+  vector<int> upmids;
+  vector<int> downoffsets;
+  vector<int> downsources;
+  vector<int> downweights;
+  vector<int> downmids;
+
+private:
+  struct Arc {
+    int node; // other end of arc
+    int w;
+    int mid; // location the shortcut skips, -1 for a road
+  };
+
+  static void readints(istream& is, vector<int>& v, int n)
+  {
+    v.resize(n);
+    is.read((char*) v.data(), 4L * n);
+  }
+
+  // adds arc u->x, or lowers the cost of the existing one
+  void addarc(int u, int x, int w, int mid)
+  {
+    if(u == x)
+      return;
+
+    for(int i = 0; i < out[u].size(); i++)
+    {
+      if(out[u][i].node == x)
+      {
+        if(w < out[u][i].w)
+        {
+          out[u][i].w = w;
+          out[u][i].mid = mid;
+          for(int j = 0; j < in[x].size(); j++)
+          {
+            if(in[x][j].node == u)
+            {
+              in[x][j].w = w;
+              in[x][j].mid = mid;
+            }
+          }
+        }
+        return;
+      }
+    }
+
+    Arc a;
+    a.node = x;
+    a.w = w;
+    a.mid = mid;
+    out[u].push_back(a);
+    a.node = u;
+    in[x].push_back(a);
+  }
+
+  // Dijkstra from u among uncontracted locations other than v, stopping
+  // past cost limit or after settlelimit settled locations.
+  // a witness that is missed only costs an extra shortcut
+  void witness(int u, int v, int limit, int settlelimit)
+  {
+    wcost.reset(nodes);
+    wheap.reset(nodes);
+    wcost.set(u, 0, -1, -1);
+    wheap.push(u, 0);
+
+    int settled = 0;
+    while(!wheap.empty() && wheap.topkey() <= limit && settled < settlelimit)
+    {
+      int x = wheap.pop();
+      settled++;
+      for(int i = 0; i < out[x].size(); i++)
+      {
+        int y = out[x][i].node;
+        if(done[y] || y == v)
+          continue;
+        int c = wcost.cost(x) + out[x][i].w;
+        if(c < wcost.cost(y))
+        {
+          wcost.set(y, c, x, -1);
+          wheap.push(y, c);
+        }
+      }
+    }
+  }
+
+  // contracts v, adding shortcuts if add is set
+  // returns number of shortcuts needed. priority estimates use a
+  // shorter witness search than real contraction
+  int contract(int v, bool add)
+  {
+    int shortcuts = 0;
+    for(int i = 0; i < in[v].size(); i++)
+    {
+      int u = in[v][i].node;
+      int w1 = in[v][i].w;
+      if(done[u])
+        continue;
+
+      int limit = -1;
+      for(int j = 0; j < out[v].size(); j++)
+      {
+        if(!done[out[v][j].node] && out[v][j].node != u)
+          limit = max(limit, w1 + out[v][j].w);
+      }
+      if(limit == -1)
+        continue;
+
+      witness(u, v, limit, add ? 500 : 50);
+      for(int j = 0; j < out[v].size(); j++)
+      {
+        int x = out[v][j].node;
+        int c = w1 + out[v][j].w;
+        if(done[x] || x == u || wcost.cost(x) <= c)
+          continue;
+        shortcuts++;
+        if(add)
+          addarc(u, x, c, v);
+      }
+    }
+
+    return shortcuts;
+  }
+
+  // contraction order: edge difference plus contracted neighbors,
+  // which spreads contraction evenly over the graph
+  long long priority(int v)
+  {
+    int removed = 0;
+    for(int i = 0; i < in[v].size(); i++)
+      removed += !done[in[v][i].node];
+    for(int i = 0; i < out[v].size(); i++)
+      removed += !done[out[v][i].node];
+
+    return 2 * (contract(v, false) - removed) + deleted[v];
+  }
+
+  // only used while building
+  vector<vector<Arc> > out;
+  vector<vector<Arc> > in;
+  vector<char> done;
+  vector<int> deleted;
+  KeyHeap wheap;
+  CostTable wcost;
+};
+
+// counters of one search, written by --stats
+// search() zeroes them, the searches only add to them
+struct SearchStats {
+  long long expanded; // locations whose roads were followed
+  long long generated; // children created or costs lowered
+  long long duplicates; // children of locations already seen or on the path
+  long long peakFrontier;
+  long long peakExplored;
+
+  void peak(long long frontier, long long explored)
+  {
+    peakFrontier = max(peakFrontier, frontier);
+    peakExplored = max(peakExplored, explored);
+  }
+};
+
+// reusable barrier for a fixed number of threads
+class Barrier {
+public:
+  Barrier(int n) : count(n), waiting(0), generation(0) {}
+
+  void wait()
+  {
+    unique_lock<mutex> lock(m);
+    int gen = generation;
+    if(++waiting == count)
+    {
+      waiting = 0;
+      generation++;
+      cv.notify_all();
+    }
+    else
+      cv.wait(lock, [&] { return gen != generation; });
+  }
+
+private:
+  int count;
+  int waiting;
+  int generation;
+  mutex m;
+  condition_variable cv;
+};
+
+// parallel delta-stepping single-source shortest paths
+// locations wait in buckets of width delta by tentative cost. the lowest
+// bucket is emptied in rounds: all threads relax the light roads
+// (cost <= delta) of its locations in parallel until no location falls
+// back into it, then the heavy roads of everything it held once.
+// cost and parent road of each location share one 64-bit atomic, cost
+// in the high half, so a compare-and-swap updates both. only a strictly
+// lower cost replaces them: with zero-cost roads an equal cost through
+// another road could make a location its own ancestor. each thread files improved
+// locations in its own buckets, thread 0 merges them between rounds,
+// so relaxation takes no lock. buckets are reused cyclically since no
+// pending cost is more than the largest road cost above the current one.
+// kept in a Workspace, so its tables are reused by later runs
+class DeltaStepping {
+public:
+  DeltaStepping() : graph(NULL), n(0), capacity(0), scanned(NULL), scannedversion(-1), maxweight(0), meanweight(1) {}
+
+  // finds costs from start until goal is settled (goal -1 runs to the end)
+  // delta 0 picks the mean road cost
+  void run(Graph& g, int start, int goal, int delta, int threads)
+  {
+    scan(g);
+    graph = &g;
+    this->goal = goal;
+    this->delta = delta > 0 ? delta : meanweight;
+    nthreads = max(threads, 1);
+    n = g.size();
+    nbuckets = maxweight / this->delta + 2;
+
+    if(capacity < n)
+    {
+      best.reset(new atomic<unsigned long long>[n]);
+      capacity = n;
+    }
+    for(int i = 0; i < n; i++)
+      best[i].store(NONE, memory_order_relaxed);
+    // a run stopped at its goal can leave locations in the buckets
+    local.resize(nthreads);
+    for(int t = 0; t < nthreads; t++)
+    {
+      local[t].resize(nbuckets);
+      for(int b = 0; b < nbuckets; b++)
+        local[t][b].clear();
+    }
+    generated.assign(nthreads, 0);
+    reopened.assign(nthreads, 0);
+    expanded = 0;
+    peak = 0;
+    queued.assign(n, 0);
+    frontier.clear();
+    removed.clear();
+
+    best[start].store(pack(0, UINT_MAX), memory_order_relaxed);
+    local[0][0].push_back(start);
+    current = 0;
+    heavy = false;
+    stop = false;
+
+    Barrier barrier(nthreads);
+    vector<thread> workers;
+    for(int t = 1; t < nthreads; t++)
+      workers.push_back(thread(&DeltaStepping::work, this, t, ref(barrier)));
+    work(0, barrier);
+    for(int t = 0; t < workers.size(); t++)
+      workers[t].join();
+  }
+
+  // adds counters of the last run to stats
+  void count(SearchStats& stats) const
+  {
+    stats.expanded += expanded;
+    for(int t = 0; t < nthreads; t++)
+    {
+      stats.generated += generated[t];
+      stats.duplicates += reopened[t];
+    }
+    stats.peak(peak, expanded);
+  }
+
+  // bytes held by the tables, which only grow between runs
+  long long bytes() const
+  {
+    long long total = (long long) capacity * sizeof(atomic<unsigned long long>) + queued.capacity()
+      + (frontier.capacity() + removed.capacity()) * sizeof(int)
+      + (generated.capacity() + reopened.capacity()) * sizeof(long long);
+    for(int t = 0; t < local.size(); t++)
+    {
+      total += sizeof(vector<int>) * local[t].capacity();
+      for(int b = 0; b < local[t].size(); b++)
+        total += local[t][b].capacity() * sizeof(int);
+    }
+    return total;
+  }
+
+  // cost of location v, INF if unreached
+  int cost(int v) const
+  {
+    unsigned long long b = best[v].load(memory_order_relaxed);
+    return b == NONE ? INF : (int) (b >> 32);
+  }
+
+  // road used to reach v, -1 for start or unreached
+  int via(int v) const
+  {
+    unsigned e = (unsigned) best[v].load(memory_order_relaxed);
+    return e == UINT_MAX ? -1 : (int) e;
+  }
+
+private:
+  static const unsigned long long NONE = ~0ULL;
+
+  static unsigned long long pack(int cost, unsigned edge)
+  {
+    return ((unsigned long long) cost << 32) | edge;
+  }
+
+  // largest and mean road cost, scanned once per graph version
+  void scan(const Graph& g)
+  {
+    if(scanned == &g && scannedversion == g.version)
+      return;
+    long long total = 0;
+    maxweight = 0;
+    for(int e = 0; e < g.edges; e++)
+    {
+      total += g.weights[e];
+      maxweight = max(maxweight, g.weights[e]);
+    }
+    meanweight = g.edges > 0 ? max(total / g.edges, 1LL) : 1;
+    scanned = &g;
+    scannedversion = g.version;
+  }
+
+  void work(int t, Barrier& barrier)
+  {
+    while(true)
+    {
+      barrier.wait();
+      if(t == 0)
+        next();
+      barrier.wait();
+      if(stop)
+        return;
+
+      // each thread takes every nthreads-th location of the round
+      for(int i = t; i < frontier.size(); i += nthreads)
+      {
+        int u = frontier[i];
+        int cu = cost(u);
+        for(int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++)
+        {
+          int w = graph->weights[e];
+          if((w > delta) == heavy && graph->targets[e] != u)
+            relax(t, graph->targets[e], cu + w, e);
+        }
+      }
+    }
+  }
+
+  // lowers cost of v to c through road e if c is below its cost
+  // and files v in this thread's bucket for c
+  void relax(int t, int v, int c, int e)
+  {
+    unsigned long long candidate = pack(c, e);
+    unsigned long long old = best[v].load(memory_order_relaxed);
+    while((unsigned long long) c < (old >> 32))
+    {
+      if(best[v].compare_exchange_weak(old, candidate, memory_order_relaxed))
+      {
+        generated[t]++;
+        if(old != NONE)
+          reopened[t]++;
+        local[t][(c / delta) % nbuckets].push_back(v);
+        return;
+      }
+    }
+  }
+
+  // collects bucket b from every thread into frontier, skipping
+  // locations that since moved to a cheaper bucket and duplicates
+  void gather(int b)
+  {
+    frontier.clear();
+    for(int t = 0; t < nthreads; t++)
+    {
+      vector<int>& bucket = local[t][b % nbuckets];
+      for(int i = 0; i < bucket.size(); i++)
+      {
+        int v = bucket[i];
+        if(cost(v) / delta == b && !queued[v])
+        {
+          queued[v] = 1;
+          frontier.push_back(v);
+        }
+      }
+      bucket.clear();
+    }
+    for(int i = 0; i < frontier.size(); i++)
+      queued[frontier[i]] = 0;
+  }
+
+  // picks the work of the next round. only run by thread 0
+  void next()
+  {
+    expanded += frontier.size();
+    peak = max(peak, (long long) frontier.size());
+    if(!heavy)
+    {
+      gather(current);
+      if(!frontier.empty())
+      {
+        removed.insert(removed.end(), frontier.begin(), frontier.end());
+        return;
+      }
+
+      // bucket stays empty, relax heavy roads of all it held
+      heavy = true;
+      frontier.swap(removed);
+      removed.clear();
+      return;
+    }
+
+    // bucket finished. no cheaper location can appear any more, so the
+    // goal is settled once it lies below the next bucket
+    heavy = false;
+    if(goal != -1 && cost(goal) < (long long) (current + 1) * delta)
+    {
+      stop = true;
+      return;
+    }
+
+    int last = current;
+    for(int step = 1; step <= nbuckets; step++)
+    {
+      int b = last + step;
+      for(int t = 0; t < nthreads; t++)
+      {
+        if(!local[t][b % nbuckets].empty())
+        {
+          current = b;
+          gather(current);
+          if(!frontier.empty())
+          {
+            removed.insert(removed.end(), frontier.begin(), frontier.end());
+            return;
+          }
+        }
+      }
+    }
+
+    stop = true;
+  }
+
+  Graph* graph;
+  int goal;
+  int delta;
+  int nthreads;
+  int n;
+  int nbuckets;
+  int capacity; // locations best has room for
+  const Graph* scanned; // graph and version maxweight and meanweight are of
+  int scannedversion;
+  int maxweight;
+  int meanweight;
+  unique_ptr<atomic<unsigned long long>[]> best;
+  vector<vector<vector<int> > > local; // buckets of each thread
+  vector<char> queued; // in frontier, used by gather
+  vector<int> frontier; // locations relaxed this round
+  vector<int> removed; // locations taken from current bucket so far
+  int current; // bucket being emptied
+  bool heavy; // round relaxes heavy roads
+  bool stop;
+  vector<long long> generated; // costs lowered by each thread
+  vector<long long> reopened; // of those, locations already reached
+  long long expanded; // locations relaxed over all rounds
+  long long peak; // largest round
+};
+
+// per-query search state: node pool, frontiers and membership sets
+// kept between queries so repeated searches reuse the same memory
+class Workspace {
+public:
+  Workspace() : threads(0) {}
+
+  // prepares workspace for a search over a graph with n locations
+  void reset(int n)
+  {
+    pool.reset();
+    queue.clear();
+    stack.clear();
+    heap.reset(n);
+    inFrontier.reset(n);
+    explored.reset(n);
+  }
+
+  NodePool pool;
+  deque<int> queue; // BFS frontier
+  vector<int> stack; // DFS frontier
+  Frontier heap; // UCS and A* frontier
+  StateSet inFrontier;
+  StateSet explored;
+  vector<int> path; // scratch used when writing results
+  CostTable fcost; // forward costs of bidirectional searches
+  CostTable bcost; // backward costs of bidirectional searches
+  KeyHeap fheap;
+  KeyHeap bheap;
+  vector<int> steps; // scratch for unpacked shortcuts
+  StateSet wanted; // goals of one-to-many search
+  DeltaStepping delta; // DELTA engine
+  int threads; // threads DELTA may use, 0 for OPTIONS.threads
+  SearchStats stats;
+
+  // bytes held by the workspace, which only grows between searches
+  long long bytes() const
+  {
+    return pool.nodes.capacity() * sizeof(Node) + queue.size() * sizeof(int)
+      + stack.capacity() * sizeof(int) + heap.bytes() + inFrontier.bytes()
+      + explored.bytes() + path.capacity() * sizeof(int) + fcost.bytes()
+      + bcost.bytes() + fheap.bytes() + bheap.bytes()
+      + steps.capacity() * sizeof(int) + wanted.bytes() + delta.bytes();
+  }
+};
+
+// collects pool indices of path from start to goal node n in w.path
+// path is rebuilt by walking parent links from n back to start
+void tracepath(int n, Workspace& w)
+{
+  w.path.clear();
+  for(int i = n; i != -1; i = w.pool[i].parent)
+    w.path.push_back(i);
+  reverse(w.path.begin(), w.path.end());
+}
+
+// appends decimal form of v to out
+void putnumber(string& out, int v)
+{
+  char buf[16];
+  int n = 0;
+  unsigned u = v < 0 ? 0u - (unsigned) v : v;
+  do
+  {
+    buf[n++] = '0' + u % 10;
+    u /= 10;
+  } while(u > 0);
+  if(v < 0)
+    out += '-';
+  while(n > 0)
+    out += buf[--n];
+}
+
+// prints path and accumulated time from start to each location in output.txt
+// the whole result is formatted in memory and written with one call
+void printout(int n, Workspace& w, Graph& g)
+{
+  tracepath(n, w);
+
+  string out;
+  for(int i = 0; i < w.path.size(); i++)
+  {
+    out += g.name(w.pool[w.path[i]].state);
+    out += ' ';
+    putnumber(out, w.pool[w.path[i]].pathCost);
+    out += '\n';
+  }
+
+  ofstream ofs;
+  ofs.open("output.txt", std::ofstream::out | std::ofstream::trunc);
+  ofs.write(out.data(), out.size());
+  ofs.close();
+}
+
+// writes path and accumulated times as one line. used by batch mode
+// n is -1 if there is no solution
+void printrecord(int n, Workspace& w, Graph& g, ostream& os)
+{
+  if(n == -1)
+  {
+    os << "No solution\n";
+    return;
+  }
+
+  tracepath(n, w);
+  string out;
+  for(int i = 0; i < w.path.size(); i++)
+  {
+    if(i > 0)
+      out += ' ';
+    out += g.name(w.pool[w.path[i]].state);
+    out += ' ';
+    putnumber(out, w.pool[w.path[i]].pathCost);
+  }
+  out += '\n';
+  os.write(out.data(), out.size());
+}
+
+// adds start node to pool and returns its index
+int start_node(int start, NodePool& pool)
+{
+  Node node;
+  node.state = start;
+  node.pathCost = 0;
+  node.totalCost = 0;
+  node.parent = -1;
+  return pool.add(node);
+}
+
+// Breadth-first search
+// returns pool index of goal node, or -1 if there is no solution
+int bfs(int start, int goal, Graph& g, Workspace& w)
+{
+  Estimate none = estimator(g, H_NONE, goal);
+  w.reset(g.size());
+  int node = start_node(start, w.pool);
+  w.queue.push_back(node);
+  w.inFrontier.insert(start);
+
+  while(!w.queue.empty())
+  {
+    node = w.queue.front();
+    w.queue.pop_front();
+    int state = w.pool[node].state;
+    w.inFrontier.erase(state);
+    if(state == goal)
+      return node;
+    w.explored.insert(state);
+    w.stats.expanded++;
+
+    for(int e = g.offsets[state]; e < g.offsets[state + 1]; e++)
+    {
+      int t = g.targets[e];
+      if(!w.inFrontier.contains(t) && !w.explored.contains(t))
+      {
+        w.queue.push_back(child_node(node, w.pool, g, e, none));
+        w.inFrontier.insert(t);
+        w.stats.generated++;
+      }
+      else
+        w.stats.duplicates++;
+    }
+    w.stats.peak(w.queue.size(), w.stats.expanded);
+  }
+
+  return -1;
+}
+
+// Depth-first search
+// returns pool index of goal node, or -1 if there is no solution
+int dfs(int start, int goal, Graph& g, Workspace& w)
+{
+  Estimate none = estimator(g, H_NONE, goal);
+  w.reset(g.size());
+  int node = start_node(start, w.pool);
+  w.stack.push_back(node);
+  w.inFrontier.insert(start);
+
+  while(!w.stack.empty())
+  {
+    node = w.stack.back();
+    w.stack.pop_back();
+    int state = w.pool[node].state;
+    w.inFrontier.erase(state);
+    if(state == goal)
+      return node;
+    w.explored.insert(state);
+    w.stats.expanded++;
+
+    for(int e = g.offsets[state]; e < g.offsets[state + 1]; e++)
+    {
+      int t = g.targets[e];
+      if(!w.inFrontier.contains(t) && !w.explored.contains(t))
+      {
+        w.stack.push_back(child_node(node, w.pool, g, e, none));
+        w.inFrontier.insert(t);
+        w.stats.generated++;
+      }
+      else
+        w.stats.duplicates++;
+    }
+    w.stats.peak(w.stack.size(), w.stats.expanded);
+  }
+
+  return -1;
+}
+
+// settles nodes of w.heap cheapest first and relaxes their roads
+// stops once goal is settled, or with goal -1 once the remaining
+// locations in w.wanted are, writing each settled location to w.fcost.
+// children that lose to the frontier are dropped from the pool again
+// returns pool index of goal node, or -1 if it was not reached
+int grow(int goal, int remaining, Graph& g, Workspace& w, const Estimate& est)
+{
+  while(!w.heap.empty())
+  {
+    int node = w.heap.pop();
+    int state = w.pool[node].state;
+    if(state == goal)
+      return node;
+    w.explored.insert(state);
+    if(goal == -1)
+    {
+      w.fcost.set(state, w.pool[node].pathCost, node, -1);
+      if(w.wanted.contains(state) && --remaining == 0)
+        return -1;
+    }
+    w.stats.expanded++;
+
+    for(int e = g.offsets[state]; e < g.offsets[state + 1]; e++)
+    {
+      int child = child_node(node, w.pool, g, e, est);
+      int cstate = w.pool[child].state;
+      w.stats.generated++;
+      if(!w.heap.contains(cstate) && !w.explored.contains(cstate))
+        w.heap.push(child, w.pool);
+      else if(w.heap.contains(cstate) && (w.pool[child].totalCost < w.heap.totalCost(cstate)))
+      {
+        w.heap.decrease(child, w.pool);
+        w.stats.duplicates++;
+      }
+      else
+      {
+        w.pool.nodes.pop_back();
+        w.stats.duplicates++;
+      }
+    }
+    w.stats.peak(w.heap.size(), w.stats.expanded);
+  }
+
+  return -1;
+}
+
+// best-first search shared by UCS and A*
+// h picks the heuristic A* adds to total path cost
+// returns pool index of goal node, or -1 if there is no solution
+int bestfirst(int start, int goal, Graph& g, Workspace& w, int h)
+{
+  Estimate est = estimator(g, h, goal);
+  w.reset(g.size());
+  w.heap.push(start_node(start, w.pool), w.pool);
+  return grow(goal, 0, g, w, est);
+}
+
+// Uniform cost search
+int ucs(int start, int goal, Graph& g, Workspace& w)
+{
+  return bestfirst(start, goal, g, w, H_NONE);
+}
+
+// A* search
+int astar(int start, int goal, Graph& g, Workspace& w)
+{
+  return bestfirst(start, goal, g, w, H_SUNDAY);
+}
+
+// A* search with landmark lower bounds
+// works for any goal. falls back to UCS when no landmarks are loaded or
+// road costs changed since they were built, as the bounds may then be wrong
+int alt(int start, int goal, Graph& g, Workspace& w)
+{
+  if(g.landmarks == NULL || g.landmarks->version != g.version)
+    return ucs(start, goal, g, w);
+  return bestfirst(start, goal, g, w, H_LANDMARK);
+}
+
+// adds the (location, road cost) pairs in w.steps to the pool as a chain
+// of nodes after start and returns the pool index of the last one
+int chain_nodes(int start, Workspace& w)
+{
+  int node = start_node(start, w.pool);
+  for(int i = 0; i < w.steps.size(); i += 2)
+  {
+    Node child;
+    child.state = w.steps[i];
+    child.parent = node;
+    child.pathCost = w.pool[node].pathCost + w.steps[i + 1];
+    child.totalCost = child.pathCost;
+    node = w.pool.add(child);
+  }
+
+  return node;
+}
+
+// depth-first search shared by IDDFS and IDA*
+// the pool holds only the nodes of the current path and w.stack the next
+// road to try at each depth, so memory grows with path length alone.
+// a child is cut when its bound passes limit: with h == H_SUNDAY the bound
+// is path cost plus Sunday estimate, otherwise its number of roads. the
+// smallest bound that was cut is kept in next for the following round.
+// children deeper than maxdepth are dropped without touching next
+// returns pool index of goal node, or -1 if there is none within limit
+int bounded(int start, int goal, Graph& g, Workspace& w, int h, int limit, int maxdepth, int& next)
+{
+  Estimate est = estimator(g, h, goal);
+  w.pool.reset();
+  w.stack.clear();
+  int node = start_node(start, w.pool);
+  if(start == goal)
+    return node;
+  w.stack.push_back(g.offsets[start]);
+  w.stats.expanded++;
+
+  while(!w.stack.empty())
+  {
+    node = w.pool.nodes.size() - 1;
+    int state = w.pool[node].state;
+    int e = w.stack.back();
+    if(e == g.offsets[state + 1])
+    {
+      w.stack.pop_back();
+      w.pool.nodes.pop_back();
+      continue;
+    }
+    w.stack.back()++;
+
+    // skip locations already on the path
+    int t = g.targets[e];
+    bool cycle = false;
+    for(int i = 0; i <= node && !cycle; i++)
+      cycle = w.pool[i].state == t;
+    if(cycle)
+      w.stats.duplicates++;
+    if(cycle || node + 1 > maxdepth)
+      continue;
+
+    int child = child_node(node, w.pool, g, e, est);
+    w.stats.generated++;
+    int bound = h == H_SUNDAY ? w.pool[child].totalCost : child;
+    if(bound > limit)
+    {
+      next = min(next, bound);
+      w.pool.nodes.pop_back();
+      continue;
+    }
+    if(t == goal)
+      return child;
+    w.stack.push_back(g.offsets[t]);
+    w.stats.expanded++;
+    w.stats.peak(w.stack.size(), w.stack.size());
+  }
+
+  return -1;
+}
+
+// iterative deepening shared by IDDFS and IDA*
+// repeats bounded with the limit raised to the smallest bound cut in the
+// previous round until the goal is found or nothing was cut.
+// OPTIONS.memory caps the path depth; routes longer than the cap are not
+// found, trading completeness for memory on small machines
+int deepening(int start, int goal, Graph& g, Workspace& w, int h)
+{
+  int maxdepth = INT_MAX;
+  if(OPTIONS.memory > 0)
+    maxdepth = min((long long) INT_MAX, OPTIONS.memory / (long long) (sizeof(Node) + sizeof(int)));
+
+  int limit = h == H_SUNDAY ? estimator(g, h, goal)(start) : 0;
+  while(true)
+  {
+    int next = INF;
+    int node = bounded(start, goal, g, w, h, limit, maxdepth, next);
+    if(node != -1 || next >= INF)
+      return node;
+    limit = next;
+  }
+}
+
+// Iterative-deepening depth-first search
+// finds a route with the fewest roads, like BFS
+int iddfs(int start, int goal, Graph& g, Workspace& w)
+{
+  return deepening(start, goal, g, w, H_NONE);
+}
+
+// Iterative-deepening A* search with the Sunday heuristic
+// costs equal A* while the Sunday table is admissible
+int idastar(int start, int goal, Graph& g, Workspace& w)
+{
+  return deepening(start, goal, g, w, H_SUNDAY);
+}
+
+// one-to-many uniform cost search
+// grows one shortest-path tree from start until every location in goals
+// is settled, or nothing is left to expand. goals of -1 are skipped.
+// afterwards w.fcost holds the cost of every settled location and, as
+// parent, the pool index of the node that settled it
+void tree(int start, const vector<int>& goals, Graph& g, Workspace& w)
+{
+  Estimate none = estimator(g, H_NONE, -1);
+  w.reset(g.size());
+  w.fcost.reset(g.size());
+  w.wanted.reset(g.size());
+
+  int remaining = 0;
+  for(int i = 0; i < goals.size(); i++)
+  {
+    if(goals[i] != -1 && !w.wanted.contains(goals[i]))
+    {
+      w.wanted.insert(goals[i]);
+      remaining++;
+    }
+  }
+
+  if(remaining > 0)
+  {
+    w.heap.push(start_node(start, w.pool), w.pool);
+    grow(-1, remaining, g, w, none);
+  }
+}
+
+// returns pool index of node that settled v in the last tree, or -1
+int settled(int v, Workspace& w)
+{
+  return w.fcost.cost(v) < INF ? w.fcost.parent(v) : -1;
+}
+
+// bidirectional best-first search shared by BIUCS and BIA*
+// a forward search from start over roads and a backward search from goal
+// over in-edges take turns, always expanding the side with the cheaper
+// entry. with h == H_SUNDAY both sides use the average potential
+// P(v) = Sunday estimate of v, halved: keys are kept doubled as
+// 2 * cost + P(v) forward and 2 * cost - P(v) backward, which keeps
+// reduced road costs equal in both directions and makes the two keys
+// of a location add up to twice the cost of a route through it. the
+// search stops once the two cheapest keys cannot beat the best route.
+// needs a consistent Sunday table, like LPA*
+int bidirectional(int start, int goal, Graph& g, Workspace& w, int h)
+{
+  g.buildreverse();
+  w.reset(g.size());
+  w.fcost.reset(g.size());
+  w.bcost.reset(g.size());
+  w.fheap.reset(g.size());
+  w.bheap.reset(g.size());
+
+  const int* p = h == H_SUNDAY ? estimator(g, h, goal).table : NULL;
+  w.fcost.set(start, 0, -1, -1);
+  w.fheap.push(start, p ? p[start] : 0);
+  w.bcost.set(goal, 0, -1, -1);
+  w.bheap.push(goal, p ? -p[goal] : 0);
+
+  long long best = start == goal ? 0 : INF;
+  int meet = start == goal ? start : -1;
+
+  while(!w.fheap.empty() && !w.bheap.empty())
+  {
+    if(w.fheap.topkey() + w.bheap.topkey() >= 2 * best)
+      break;
+
+    if(w.fheap.topkey() <= w.bheap.topkey())
+    {
+      int u = w.fheap.pop();
+      int cu = w.fcost.cost(u);
+      w.stats.expanded++;
+      for(int e = g.offsets[u]; e < g.offsets[u + 1]; e++)
+      {
+        int v = g.targets[e];
+        int c = cu + g.weights[e];
+        if(c < w.fcost.cost(v))
+        {
+          if(w.fcost.cost(v) < INF)
+            w.stats.duplicates++;
+          w.stats.generated++;
+          w.fcost.set(v, c, u, e);
+          w.fheap.push(v, 2LL * c + (p ? p[v] : 0));
+          if(w.bcost.cost(v) < INF && c + w.bcost.cost(v) < best)
+          {
+            best = c + w.bcost.cost(v);
+            meet = v;
+          }
+        }
+      }
+    } else {
+      int u = w.bheap.pop();
+      int cu = w.bcost.cost(u);
+      w.stats.expanded++;
+      for(int k = g.roffsets[u]; k < g.roffsets[u + 1]; k++)
+      {
+        int v = g.rsources[k];
+        int c = cu + g.weights[g.redges[k]];
+        if(c < w.bcost.cost(v))
+        {
+          if(w.bcost.cost(v) < INF)
+            w.stats.duplicates++;
+          w.stats.generated++;
+          w.bcost.set(v, c, u, g.redges[k]);
+          w.bheap.push(v, 2LL * c - (p ? p[v] : 0));
+          if(w.fcost.cost(v) < INF && c + w.fcost.cost(v) < best)
+          {
+            best = c + w.fcost.cost(v);
+            meet = v;
+          }
+        }
+      }
+    }
+    w.stats.peak(w.fheap.size() + w.bheap.size(), w.stats.expanded);
+  }
+
+  if(meet == -1)
+    return -1;
+
+  // stitch start -> meet from forward parents and meet -> goal from
+  // backward parents into one chain of roads
+  w.path.clear();
+  for(int v = meet; v != start; v = w.fcost.parent(v))
+    w.path.push_back(v);
+  reverse(w.path.begin(), w.path.end());
+
+  w.steps.clear();
+  for(int i = 0; i < w.path.size(); i++)
+  {
+    w.steps.push_back(w.path[i]);
+    w.steps.push_back(g.weights[w.fcost.via(w.path[i])]);
+  }
+  for(int v = meet; v != goal; v = w.bcost.parent(v))
+  {
+    w.steps.push_back(w.bcost.parent(v));
+    w.steps.push_back(g.weights[w.bcost.via(v)]);
+  }
+
+  return chain_nodes(start, w);
+}
+
+// delta-stepping search from start to goal on OPTIONS.threads threads
+// (w.threads if set) with bucket width OPTIONS.delta (mean road cost if
+// 0). costs equal UCS
+int deltastep(int start, int goal, Graph& g, Workspace& w)
+{
+  DeltaStepping& engine = w.delta;
+  engine.run(g, start, goal, OPTIONS.delta, w.threads > 0 ? w.threads : OPTIONS.threads);
+
+  w.reset(g.size());
+  engine.count(w.stats);
+  if(engine.cost(goal) >= INF)
+    return -1;
+
+  // walk parent roads back from goal. the road's tail is found by
+  // binary search over the edge offsets
+  w.path.clear();
+  for(int v = goal; v != start; )
+  {
+    int e = engine.via(v);
+    w.path.push_back(e);
+    v = upper_bound(g.offsets, g.offsets + g.size() + 1, e) - g.offsets - 1;
+  }
+  reverse(w.path.begin(), w.path.end());
+
+  w.steps.clear();
+  for(int i = 0; i < w.path.size(); i++)
+  {
+    w.steps.push_back(g.targets[w.path[i]]);
+    w.steps.push_back(g.weights[w.path[i]]);
+  }
+
+  return chain_nodes(start, w);
+}
+
+// bidirectional uniform cost search
+int biucs(int start, int goal, Graph& g, Workspace& w)
+{
+  return bidirectional(start, goal, g, w, H_NONE);
+}
+
+// bidirectional A* search with the Sunday heuristic
+int biastar(int start, int goal, Graph& g, Workspace& w)
+{
+  return bidirectional(start, goal, g, w, H_SUNDAY);
+}
+
+// contraction hierarchy query
+// bidirectional Dijkstra that only climbs to higher ranked locations:
+// forward from start over up arcs, backward from goal over down arcs.
+// shortcuts on the best path are unpacked back into roads. costs are
+// the same as UCS; among equally cheap routes another one may be picked.
+// falls back to UCS when no hierarchy is loaded or road costs changed
+// since it was built
+int ch(int start, int goal, Graph& g, Workspace& w)
+{
+  const Hierarchy* h = g.hierarchy;
+  if(h == NULL || h->version != g.version)
+    return ucs(start, goal, g, w);
+
+  w.reset(g.size());
+  w.fcost.reset(g.size());
+  w.bcost.reset(g.size());
+  w.fheap.reset(g.size());
+  w.bheap.reset(g.size());
+  w.fcost.set(start, 0, -1, -1);
+  w.fheap.push(start, 0);
+  w.bcost.set(goal, 0, -1, -1);
+  w.bheap.push(goal, 0);
+
+  int best = start == goal ? 0 : INF;
+  int meet = start == goal ? start : -1;
+
+  while(true)
+  {
+    // a direction is finished once its cheapest entry cannot beat best
+    bool fdone = w.fheap.empty() || w.fheap.topkey() >= best;
+    bool bdone = w.bheap.empty() || w.bheap.topkey() >= best;
+    if(fdone && bdone)
+      break;
+
+    if(!fdone && (bdone || w.fheap.topkey() <= w.bheap.topkey()))
+    {
+      int u = w.fheap.pop();
+      int cu = w.fcost.cost(u);
+      w.stats.expanded++;
+      for(int k = h->upoffsets[u]; k < h->upoffsets[u + 1]; k++)
+      {
+        int v = h->uptargets[k];
+        int c = cu + h->upweights[k];
+        if(c < w.fcost.cost(v))
+        {
+          if(w.fcost.cost(v) < INF)
+            w.stats.duplicates++;
+          w.stats.generated++;
+          w.fcost.set(v, c, u, k);
+          w.fheap.push(v, c);
+          if(w.bcost.cost(v) < INF && c + w.bcost.cost(v) < best)
+          {
+            best = c + w.bcost.cost(v);
+            meet = v;
+          }
+        }
+      }
+    } else {
+      int u = w.bheap.pop();
+      int cu = w.bcost.cost(u);
+      w.stats.expanded++;
+      for(int k = h->downoffsets[u]; k < h->downoffsets[u + 1]; k++)
+      {
+        int v = h->downsources[k];
+        int c = cu + h->downweights[k];
+        if(c < w.bcost.cost(v))
+        {
+          if(w.bcost.cost(v) < INF)
+            w.stats.duplicates++;
+          w.stats.generated++;
+          w.bcost.set(v, c, u, k);
+          w.bheap.push(v, c);
+          if(w.fcost.cost(v) < INF && c + w.fcost.cost(v) < best)
+          {
+            best = c + w.fcost.cost(v);
+            meet = v;
+          }
+        }
+      }
+    }
+    w.stats.peak(w.fheap.size() + w.bheap.size(), w.stats.expanded);
+  }
+
+  if(meet == -1)
+    return -1;
+
+  // arcs from start up to meet, collected backwards then reversed
+  vector<int>& arcs = w.path;
+  arcs.clear();
+  for(int v = meet; v != start; v = w.fcost.parent(v))
+    arcs.push_back(w.fcost.via(v));
+  reverse(arcs.begin(), arcs.end());
+
+  w.steps.clear();
+  int u = start;
+  for(int i = 0; i < arcs.size(); i++)
+  {
+    int k = arcs[i];
+    h->unpack(u, h->uptargets[k], h->upweights[k], h->upmids[k], w.steps);
+    u = h->uptargets[k];
+  }
+  for(int v = meet; v != goal; v = w.bcost.parent(v))
+  {
+    int k = w.bcost.via(v);
+    h->unpack(v, w.bcost.parent(v), h->downweights[k], h->downmids[k], w.steps);
+  }
+
+  return chain_nodes(start, w);
+}
+
+// runs algorithm a from start to goal
+// returns pool index of goal node, or -1 if there is no solution
+int search(int a, int start, int goal, Graph& g, Workspace& w)
+{
+  w.stats = SearchStats();
+  switch(a)
+  {
+    case 0:
+      return bfs(start, goal, g, w);
+    case 1:
+      return dfs(start, goal, g, w);
+    case 2:
+      return ucs(start, goal, g, w);
+    case 3:
+      return astar(start, goal, g, w);
+    case 4:
+      return alt(start, goal, g, w);
+    case 5:
+      return ch(start, goal, g, w);
+    case 6:
+      return biucs(start, goal, g, w);
+    case 7:
+      return biastar(start, goal, g, w);
+    case 8:
+      return deltastep(start, goal, g, w);
+    case 9:
+      return idastar(start, goal, g, w);
+    case 10:
+      return iddfs(start, goal, g, w);
+    default:
+      break;
+  }
+
+  return -1;
+}
+
+// milliseconds since t
+double since(chrono::steady_clock::time_point t)
+{
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - t).count();
+}
+
+// destination of --stats output and the time it took to load the graph
+struct StatsLog {
+  ostream* os;
+  double parse; // milliseconds
+};
+
+// quotes s as a JSON string
+string jsonstring(const string& s)
+{
+  ostringstream out;
+  out << '"';
+  for(int i = 0; i < s.size(); i++)
+  {
+    unsigned char c = s[i];
+    if(c == '"' || c == '\\')
+      out << '\\' << c;
+    else if(c < 0x20)
+    {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out << buf;
+    }
+    else
+      out << c;
+  }
+  out << '"';
+  return out.str();
+}
+
+// formats the counters of the search that returned node as one JSON line
+// elapsed is the search time in milliseconds. a cached answer ran no search
+string statsline(const string& alg, const string& start, const string& goal, int node, Workspace& w, StatsLog& log, double elapsed, bool cached)
+{
+  ostringstream out;
+  out << "{\"alg\":" << jsonstring(alg) << ",\"start\":" << jsonstring(start)
+      << ",\"goal\":" << jsonstring(goal);
+  if(cached)
+    out << ",\"cached\":true";
+  else
+  {
+    out << ",\"found\":" << (node != -1 ? "true" : "false");
+    if(node != -1)
+      out << ",\"cost\":" << w.pool[node].pathCost;
+    out << ",\"expanded\":" << w.stats.expanded
+        << ",\"generated\":" << w.stats.generated
+        << ",\"duplicates\":" << w.stats.duplicates
+        << ",\"peak_frontier\":" << w.stats.peakFrontier
+        << ",\"peak_explored\":" << w.stats.peakExplored
+        << ",\"bytes\":" << w.bytes();
+  }
+  out << ",\"parse_ms\":" << log.parse << ",\"search_ms\":" << elapsed << "}\n";
+  return out.str();
+}
+
+// Lifelong Planning A* (LPA*) from start to goal over live traffic
+// dist is the best known cost of each location, rhs the cost through its
+// best predecessor. when a road cost changes only the locations whose
+// dist and rhs disagree go back in the heap, so replanning work follows
+// the size of the change rather than the size of the graph.
+// bool b adds the Sunday heuristic, which must be consistent for LPA*
+class Replanner {
+public:
+  Replanner(Graph& g, int start, int goal, bool b) : graph(g), start(start), goal(goal), useh(b)
+  {
+    est = estimator(g, b ? H_SUNDAY : H_NONE, goal);
+    graph.buildreverse();
+    dist.assign(graph.size(), INF);
+    rhs.assign(graph.size(), INF);
+    heap.reset(graph.size());
+    rhs[start] = 0;
+    heap.push(start, key(start));
+  }
+
+  // repairs dist until the path to goal is known again
+  void plan()
+  {
+    while(!heap.empty() && (heap.topkey() < key(goal) || rhs[goal] != dist[goal]))
+    {
+      int u = heap.pop();
+      if(dist[u] > rhs[u])
+      {
+        dist[u] = rhs[u];
+        for(int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+          updatevertex(graph.targets[e]);
+      } else {
+        dist[u] = INF;
+        updatevertex(u);
+        for(int e = graph.offsets[u]; e < graph.offsets[u + 1]; e++)
+          updatevertex(graph.targets[e]);
+      }
+    }
+  }
+
+  // sets cost of road from a to b to c. with several roads from a to b
+  // the first one is changed. returns false if there is no such road
+  bool update(int a, int b, int c)
+  {
+    int e = graph.findedge(a, b);
+    if(e == -1)
+      return false;
+
+    graph.setweight(e, c);
+    reestimate();
+    updatevertex(b);
+    return true;
+  }
+
+  // cost of the planned path, INF if goal cannot be reached
+  int cost() const { return dist[goal]; }
+
+  // writes path and accumulated time from start to each location,
+  // one per line as in output.txt, followed by an empty line
+  void write(ostream& os)
+  {
+    if(dist[goal] >= INF)
+    {
+      os << "No solution\n\n";
+      return;
+    }
+
+    // walk back from goal through predecessors that give its cost
+    path.clear();
+    path.push_back(goal);
+    for(int v = goal; v != start && path.size() <= graph.size(); )
+    {
+      for(int k = graph.roffsets[v]; k < graph.roffsets[v + 1]; k++)
+      {
+        int u = graph.rsources[k];
+        if(dist[u] < INF && dist[u] + graph.weights[graph.redges[k]] == dist[v])
+        {
+          v = u;
+          break;
+        }
+      }
+      path.push_back(v);
+    }
+
+    for(int i = path.size() - 1; i >= 0; i--)
+      os << graph.name(path[i]) << " " << dist[path[i]] << "\n";
+    os << "\n";
+  }
+
+private:
+  // resolves the heuristic again after a road cost change, since tables
+  // built on the old costs are dropped then, and rekeys the heap with it
+  void reestimate()
+  {
+    Estimate next = estimator(graph, useh ? H_SUNDAY : H_NONE, goal);
+    if(next.table == est.table && next.source == est.source)
+      return;
+
+    est = next;
+    path.clear();
+    for(int i = 0; i < heap.size(); i++)
+      path.push_back(heap.at(i));
+    for(int i = 0; i < path.size(); i++)
+      heap.push(path[i], key(path[i]));
+  }
+
+  long long key(int s)
+  {
+    long long m = min(dist[s], rhs[s]);
+    long long k1 = m;
+    if(useh && m < INF)
+      k1 += est(s);
+    return (k1 << 32) | m;
+  }
+
+  void updatevertex(int u)
+  {
+    if(u != start)
+    {
+      rhs[u] = INF;
+      for(int k = graph.roffsets[u]; k < graph.roffsets[u + 1]; k++)
+      {
+        int p = graph.rsources[k];
+        if(dist[p] < INF)
+          rhs[u] = min(rhs[u], dist[p] + graph.weights[graph.redges[k]]);
+      }
+    }
+
+    if(dist[u] != rhs[u])
+      heap.push(u, key(u));
+    else if(heap.contains(u))
+      heap.remove(u);
+  }
+
+  Graph& graph;
+  int start;
+  int goal;
+  bool useh;
+  Estimate est;
+  vector<int> dist;
+  vector<int> rhs;
+  KeyHeap heap;
+  vector<int> path;
+};
+
+// replan mode. plans from start to goal once, then reads "A B COST"
+// road changes from in and writes the repaired path after each one
+void replan(istream& in, ostream& out, Graph& g, int start, int goal, bool b)
+{
+  Replanner planner(g, start, goal, b);
+  planner.plan();
+  planner.write(out);
+
+  string a;
+  string c;
+  int cost;
+  while(in >> a >> c >> cost)
+  {
+    int u = g.find(a);
+    int v = g.find(c);
+    if(u == -1 || v == -1 || cost < 0 || !planner.update(u, v, cost))
+      cerr << "Unknown road " << a << " " << c << "\n";
+    else
+      planner.plan();
+    planner.write(out);
+    out.flush();
+  }
+}
+
+// splits a file into whitespace separated tokens without copying it
+// the file is memory-mapped, or read into a buffer when it cannot be
+// (pipes, empty files). tokens point into the file and stay valid
+// until the tokenizer is destroyed
+class Tokenizer {
+public:
+  Tokenizer() : pos(NULL), end(NULL), mapping(NULL), maplen(0) {}
+
+  ~Tokenizer()
+  {
+    if(mapping != NULL)
+      munmap(mapping, maplen);
+  }
+
+  bool open(const char* file)
+  {
+    int fd = ::open(file, O_RDONLY);
+    if(fd == -1)
+      return false;
+
+    struct stat st;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+      void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(p != MAP_FAILED)
+      {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        mapping = p;
+        maplen = st.st_size;
+        pos = (const char*) p;
+        end = pos + maplen;
+      }
+    }
+
+    if(mapping == NULL)
+    {
+      char chunk[65536];
+      ssize_t n;
+      while((n = read(fd, chunk, sizeof(chunk))) > 0)
+        buffer.insert(buffer.end(), chunk, chunk + n);
+      pos = buffer.data();
+      end = pos + buffer.size();
+    }
+
+    close(fd);
+    return true;
+  }
+
+  // next token as start and length, false at end of file
+  bool word(const char*& s, int& len)
+  {
+    while(pos < end && (unsigned char) *pos <= ' ')
+      pos++;
+    if(pos == end)
+      return false;
+
+    s = pos;
+    while(pos < end && (unsigned char) *pos > ' ')
+      pos++;
+    len = pos - s;
+    return true;
+  }
+
+  bool word(string& s)
+  {
+    const char* p;
+    int len;
+    if(!word(p, len))
+      return false;
+    s.assign(p, len);
+    return true;
+  }
+
+  // next token as a decimal integer, false if it is missing or not one
+  bool number(int& v)
+  {
+    const char* s;
+    int len;
+    if(!word(s, len))
+      return false;
+
+    int i = s[0] == '-' || s[0] == '+' ? 1 : 0;
+    if(i == len)
+      return false;
+    long long x = 0;
+    for(int k = i; k < len; k++)
+    {
+      if(s[k] < '0' || s[k] > '9')
+        return false;
+      x = x * 10 + (s[k] - '0');
+    }
+    v = s[0] == '-' ? -x : x;
+    return true;
+  }
+
+private:
+  const char* pos;
+  const char* end;
+  void* mapping;
+  size_t maplen;
+  vector<char> buffer;
+};
+
+// reads input.txt style file into alg, start, goal, graph and Sunday table
+// location names are interned into the graph as they are read
+bool load(const char* file, string& alg, string& start, string& goal, Graph& graph)
+{
+  Tokenizer in;
+  int lines = 0;
+  const char* name;
+  int len;
+
+  if(!in.open(file))
+    return false;
+
+  in.word(alg);
+  in.word(start);
+  in.word(goal);
+  in.number(lines);
+  graph.intern(start);
+  graph.intern(goal);
+
+  vector<int> from;
+  vector<int> to;
+  vector<int> cost;
+  from.reserve(max(lines, 0));
+  to.reserve(max(lines, 0));
+  cost.reserve(max(lines, 0));
+  for(int i = 0; i < lines; i++)
+  {
+    int a, b, c;
+    if(!in.word(name, len))
+      break;
+    a = graph.intern(name, len);
+    if(!in.word(name, len))
+      break;
+    b = graph.intern(name, len);
+    if(!in.number(c))
+      break;
+    from.push_back(a);
+    to.push_back(b);
+    cost.push_back(c);
+  }
+
+  lines = 0;
+  in.number(lines);
+
+  vector<int> hid;
+  vector<int> hcost;
+  hid.reserve(max(lines, 0));
+  hcost.reserve(max(lines, 0));
+  for(int i = 0; i < lines; i++)
+  {
+    int c;
+    if(!in.word(name, len))
+      break;
+    int id = graph.lookup(name, len);
+    if(!in.number(c))
+      break;
+    hid.push_back(id);
+    hcost.push_back(c);
+  }
+
+  graph.build(from, to, cost, hid, hcost);
+
+  return true;
+}
+
+// Sunday tables of several goals, loaded at once by --heuristics and
+// picked by the goal of each query. the file holds blocks of a line
+// "GOAL COUNT" followed by COUNT lines "LOCATION COST", each block laid
+// out like the Sunday table of input.txt
+class GoalTables : public Heuristic {
+public:
+  // reads tables for locations of g. blocks for unknown goals and lines
+  // for unknown locations are skipped. returns false if file cannot be read
+  bool open(const char* file, Graph& g)
+  {
+    Tokenizer in;
+    if(!in.open(file))
+      return false;
+    version = g.version;
+
+    const char* name;
+    int len;
+    int count;
+    while(in.word(name, len) && in.number(count))
+    {
+      int goal = g.find(string(name, len));
+      vector<int>* t = NULL;
+      if(goal != -1)
+      {
+        t = &tables[goal];
+        t->assign(g.size(), 0);
+      }
+
+      for(int i = 0; i < count; i++)
+      {
+        int c;
+        if(!in.word(name, len) || !in.number(c))
+          return false;
+        int v = t != NULL ? g.find(string(name, len)) : -1;
+        if(v != -1)
+          (*t)[v] += c;
+      }
+    }
+
+    return true;
+  }
+
+  // uses costs to goal as its table, 0 where goal cannot be reached
+  void add(int goal, const vector<int>& costs, Graph& g)
+  {
+    vector<int>& t = tables[goal];
+    t.resize(costs.size());
+    for(int v = 0; v < costs.size(); v++)
+      t[v] = costs[v] >= INF ? 0 : costs[v];
+    version = g.version;
+  }
+
+  const int* table(int goal) const
+  {
+    unordered_map<int, vector<int> >::const_iterator it = tables.find(goal);
+    return it == tables.end() ? NULL : it->second.data();
+  }
+
+  int estimate(int v, int goal) const
+  {
+    const int* t = table(goal);
+    return t != NULL ? t[v] : 0;
+  }
+
+private:
+  unordered_map<int, vector<int> > tables;
+};
+
+// writes exact live costs to every goal named in goals as tables for
+// --heuristics. exact costs are consistent until an UPDATE changes a
+// road cost, then the tables are no longer used. 0 marks an unreachable goal
+bool buildheuristics(Graph& g, const char* goals, const char* file)
+{
+  Tokenizer in;
+  if(!in.open(goals))
+  {
+    cerr << "Cannot open " << goals << "\n";
+    return false;
+  }
+
+  ofstream out(file);
+  if(!out.is_open())
+  {
+    cerr << "Cannot write " << file << "\n";
+    return false;
+  }
+
+  vector<int> dist(g.size());
+  KeyHeap heap;
+  string name;
+  string line;
+  while(in.word(name))
+  {
+    int goal = g.find(name);
+    if(goal == -1)
+    {
+      cerr << "Unknown location " << name << "\n";
+      continue;
+    }
+
+    shortestcosts(g, goal, true, dist.data(), heap);
+    out << name << " " << g.size() << "\n";
+    for(int v = 0; v < g.size(); v++)
+    {
+      line = g.name(v);
+      line += ' ';
+      putnumber(line, dist[v] >= INF ? 0 : dist[v]);
+      line += '\n';
+      out.write(line.data(), line.size());
+    }
+  }
+
+  return true;
+}
+
+// synthetic road network with about edges roads, written to lr
+// "grid": square city grid of two-way streets, G<x>_<y>
+// "road": grid of towns at jittered positions, streets missing here and
+//   there, costs by distance and congestion, fast highways every 8 towns
+// "random": N<i> with roads between random locations
+// "zero": like random, but roads cost 0 to 3 and every tenth is a
+//   self-loop, so there are zero-cost loops and cycles
+// start and goal are picked far apart. returns false for unknown style
+bool generate(const string& style, long long edges, unsigned seed, vector<LiveRow>& lr, string& start, string& goal)
+{
+  mt19937 rng(seed);
+  lr.clear();
+
+  if(style == "grid" || style == "road")
+  {
+    bool road = style == "road";
+    int side = max(2, (int) ceil(sqrt(edges / (road ? 3.6 : 4.0))));
+    vector<double> x(side * side);
+    vector<double> y(side * side);
+    uniform_real_distribution<double> jitter(-30, 30);
+    for(int i = 0; i < side * side; i++)
+    {
+      x[i] = (i % side) * 100 + (road ? jitter(rng) : 0);
+      y[i] = (i / side) * 100 + (road ? jitter(rng) : 0);
+    }
+
+    uniform_int_distribution<int> cost(1, 9);
+    uniform_real_distribution<double> congestion(1, 3);
+    uniform_real_distribution<double> chance(0, 1);
+
+    // two-way road between towns a and b costing c each way
+    auto link = [&](int a, int b, int c) {
+      LiveRow r;
+      r.a = "G" + to_string(a % side) + "_" + to_string(a / side);
+      r.b = "G" + to_string(b % side) + "_" + to_string(b / side);
+      r.c = max(c, 1);
+      lr.push_back(r);
+      swap(r.a, r.b);
+      lr.push_back(r);
+    };
+
+    for(int v = 0; v < side; v++)
+    {
+      for(int u = 0; u < side; u++)
+      {
+        int a = v * side + u;
+        int next[2] = { u + 1 < side ? a + 1 : -1, v + 1 < side ? a + side : -1 };
+        for(int k = 0; k < 2; k++)
+        {
+          int b = next[k];
+          if(b == -1)
+            continue;
+          if(!road)
+            link(a, b, cost(rng));
+          else if(chance(rng) < 0.9)
+            link(a, b, hypot(x[a] - x[b], y[a] - y[b]) * congestion(rng) / 10);
+        }
+
+        // highways are straight and uncongested
+        if(road && u % 8 == 0 && v % 8 == 0)
+        {
+          if(u + 8 < side)
+            link(a, a + 8, hypot(x[a] - x[a + 8], y[a] - y[a + 8]) / 20);
+          if(v + 8 < side)
+            link(a, a + 8 * side, hypot(x[a] - x[a + 8 * side], y[a] - y[a + 8 * side]) / 20);
+        }
+      }
+    }
+
+    start = "G0_0";
+    goal = "G" + to_string(side - 1) + "_" + to_string(side - 1);
+    return true;
+  }
+
+  if(style == "random" || style == "zero")
+  {
+    bool zero = style == "zero";
+    int n = max(2LL, edges / 5);
+    uniform_int_distribution<int> location(0, n - 1);
+    uniform_int_distribution<int> cost(zero ? 0 : 1, zero ? 3 : 100);
+    for(long long i = 0; i < edges; i++)
+    {
+      LiveRow r;
+      r.a = "N" + to_string(location(rng));
+      r.b = "N" + to_string(location(rng));
+      r.c = cost(rng);
+      if(zero && i % 10 == 0)
+        r.b = r.a;
+      lr.push_back(r);
+    }
+
+    start = "N0";
+    goal = "N" + to_string(n - 1);
+    return true;
+  }
+
+  return false;
+}
+
+// fills the Sunday table of g for goal: 3/4 of the true live cost to
+// goal, rounded down, 0 where goal cannot be reached. scaling a true
+// cost keeps the table consistent, so A*, BIA* and LPA* may use it
+void sundaytable(Graph& g, int goal)
+{
+  vector<int> dist(g.size());
+  KeyHeap heap;
+  g.buildreverse();
+  shortestcosts(g, goal, true, dist.data(), heap);
+  for(int i = 0; i < g.size(); i++)
+    dist[i] = dist[i] >= INF ? 0 : dist[i] / 4 * 3 + dist[i] % 4 * 3 / 4;
+  g.setheuristic(dist);
+}
+
+// builds graph from generated roads and gives it a Sunday table
+void synthesize(vector<LiveRow>& lr, const string& start, const string& goal, Graph& graph)
+{
+  vector<SundayRow> sr;
+  graph.intern(start);
+  graph.intern(goal);
+  graph.build(lr, sr);
+  sundaytable(graph, graph.find(goal));
+}
+
+// generate mode. writes a synthetic network in input.txt format
+bool writegraph(const string& style, long long edges, unsigned seed, const char* file)
+{
+  vector<LiveRow> lr;
+  string start;
+  string goal;
+  Graph graph;
+  if(!generate(style, edges, seed, lr, start, goal))
+  {
+    cerr << "Unknown graph style " << style << "\n";
+    return false;
+  }
+  synthesize(lr, start, goal, graph);
+
+  ofstream out(file);
+  if(!out.is_open())
+  {
+    cerr << "Cannot write " << file << "\n";
+    return false;
+  }
+
+  out << "UCS\n" << start << "\n" << goal << "\n" << lr.size() << "\n";
+  for(int i = 0; i < lr.size(); i++)
+    out << lr[i].a << " " << lr[i].b << " " << lr[i].c << "\n";
+  out << graph.size() << "\n";
+  for(int i = 0; i < graph.size(); i++)
+    out << graph.name(i) << " " << graph.heuristic[i] << "\n";
+  return true;
+}
+
+// replans A to G with the exact goal table that --build-heuristics would
+// write, after a road change makes the A C G route the cheapest. checks
+// the repaired cost against Dijkstra and writes one bench row
+bool replancheck(ostream& out)
+{
+  const char* roads[4][2] = { { "A", "B" }, { "B", "G" }, { "A", "C" }, { "C", "G" } };
+  const int costs[4] = { 10, 10, 1, 100 };
+  vector<LiveRow> lr;
+  for(int i = 0; i < 4; i++)
+  {
+    LiveRow r;
+    r.a = roads[i][0];
+    r.b = roads[i][1];
+    r.c = costs[i];
+    lr.push_back(r);
+  }
+
+  Graph graph;
+  synthesize(lr, "A", "G", graph);
+  graph.setheuristic(vector<int>(graph.size(), 0)); // Sunday table of all 0, as in input.txt
+  int from = graph.find("A");
+  int to = graph.find("G");
+  vector<int> dist(graph.size());
+  KeyHeap heap;
+  shortestcosts(graph, to, true, dist.data(), heap);
+  GoalTables tables;
+  tables.add(to, dist, graph);
+  graph.goaltables = &tables;
+
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  Replanner planner(graph, from, to, true);
+  planner.plan();
+  planner.update(graph.find("C"), to, 1);
+  planner.plan();
+  double ms = since(begin);
+
+  shortestcosts(graph, from, false, dist.data(), heap);
+  bool ok = planner.cost() == dist[to];
+  out << "replan\t" << graph.edges << "\tLPA*\t" << ms << "\t-\t-\t" << planner.cost()
+      << "\t" << (ok ? "ok" : "FAIL") << "\n";
+  return ok;
+}
+
+// benchmark mode. runs BFS, DFS, UCS, A* and DELTA from start to goal of
+// every style at 10^3, 10^4, ... up to maxedges roads and writes one row
+// per run: time, locations expanded and bytes allocated. UCS, A* and
+// DELTA costs are checked against a plain Dijkstra run, and so is LPA*
+// replanning with an exact goal table (replancheck). returns false on
+// a mismatch
+bool bench(long long maxedges, unsigned seed, ostream& out)
+{
+  const char* styles[] = { "grid", "road", "random", "zero" };
+  const char* names[] = { "BFS", "DFS", "UCS", "A*", "DELTA" };
+  const int algs[] = { 0, 1, 2, 3, 8 };
+  bool ok = true;
+
+  out << "style\tedges\talg\tms\texpanded\tbytes\tcost\tcheck\n";
+  for(int s = 0; s < 4; s++)
+  {
+    for(long long edges = 1000; edges <= maxedges; edges *= 10)
+    {
+      vector<LiveRow> lr;
+      string start;
+      string goal;
+      Graph graph;
+      generate(styles[s], edges, seed, lr, start, goal);
+      synthesize(lr, start, goal, graph);
+      lr.clear();
+      lr.shrink_to_fit();
+
+      int from = graph.find(start);
+      int to = graph.find(goal);
+      vector<int> dist(graph.size());
+      KeyHeap heap;
+      shortestcosts(graph, from, false, dist.data(), heap);
+
+      for(int a = 0; a < 5; a++)
+      {
+        Workspace w;
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        int node = search(algs[a], from, to, graph, w);
+        double ms = since(begin);
+
+        int cost = node == -1 ? INF : w.pool[node].pathCost;
+        string check = "-";
+        if(a >= 2)
+        {
+          check = cost == dist[to] ? "ok" : "FAIL";
+          ok = ok && cost == dist[to];
+        }
+
+        out << styles[s] << "\t" << graph.edges << "\t" << names[a] << "\t" << ms
+            << "\t" << w.stats.expanded << "\t" << w.bytes() << "\t";
+        if(node == -1)
+          out << "none";
+        else
+          out << cost;
+        out << "\t" << check << "\n";
+      }
+      out.flush();
+    }
+  }
+
+  ok = replancheck(out) && ok;
+  return ok;
+}
+
+// one route request read in batch mode
+struct Query {
+  string alg;
+  string start;
+  string goal;
+};
+
+// least recently used cache of batch answers
+// keyed by algorithm, start, goal and Graph::version, so a road cost
+// change makes every older entry unreachable; those age out of the list.
+// holds the exact result lines answer writes. entries are dropped from
+// the old end while the estimated size is over budget bytes.
+// shared by all batch workers behind one lock
+class ResultCache {
+public:
+  ResultCache(long long budget) : hits(0), misses(0), budget(budget), used(0) {}
+
+  bool enabled() const { return budget > 0; }
+
+  // copies cached answer into result and marks it as recently used
+  bool get(int a, int start, int goal, int version, string& result)
+  {
+    lock_guard<mutex> lock(m);
+    unordered_map<Key, list<Entry>::iterator, KeyHash>::iterator it = index.find(Key(a, start, goal, version));
+    if(it == index.end())
+    {
+      misses++;
+      return false;
+    }
+
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->result;
+    return true;
+  }
+
+  void put(int a, int start, int goal, int version, const string& result)
+  {
+    lock_guard<mutex> lock(m);
+    Key key(a, start, goal, version);
+    if(index.count(key) > 0)
+      return;
+
+    entries.push_front(Entry(key, result));
+    index[key] = entries.begin();
+    used += size(entries.front());
+    while(used > budget && !entries.empty())
+    {
+      used -= size(entries.back());
+      index.erase(entries.back().key);
+      entries.pop_back();
+    }
+  }
+
+  long long hits;
+  long long misses;
+
+private:
+  struct Key {
+    Key(int a, int s, int g, int v) : alg(a), start(s), goal(g), version(v) {}
+    bool operator==(const Key& k) const { return alg == k.alg && start == k.start && goal == k.goal && version == k.version; }
+    int alg;
+    int start;
+    int goal;
+    int version;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& k) const
+    {
+      unsigned long long h = k.start;
+      h = h * 1000003 + k.goal;
+      h = h * 1000003 + k.version;
+      h = h * 31 + k.alg;
+      return h ^ (h >> 29);
+    }
+  };
+
+  struct Entry {
+    Entry(const Key& k, const string& r) : key(k), result(r) {}
+    Key key;
+    string result;
+  };
+
+  // rough bytes held by an entry: the string, a list node and an index slot
+  static long long size(const Entry& e)
+  {
+    return sizeof(Entry) + e.result.capacity() + 4 * sizeof(void*) + sizeof(Key);
+  }
+
+  long long budget;
+  long long used;
+  list<Entry> entries; // most recently used first
+  unordered_map<Key, list<Entry>::iterator, KeyHash> index;
+  mutex m;
+};
+
+// answers query q using workspace w and returns the result line
+// answers for known locations go through cache. with log, the stats
+// line of the query is written to stats
+string answer(Query& q, Graph& g, map<string, int>& algorithms, Workspace& w, ResultCache& cache, StatsLog* log, string& stats)
+{
+  ostringstream out;
+  map<string, int>::iterator it = algorithms.find(q.alg);
+  if(it == algorithms.end())
+  {
+    cerr << "Unknown algorithm " << q.alg << "\n";
+    out << "No solution\n";
+    return out.str();
+  }
+
+  int start = g.find(q.start);
+  int goal = g.find(q.goal);
+  if(start == -1 || goal == -1)
+  {
+    // locations without any roads can only reach themselves
+    if(q.start == q.goal)
+      out << q.start << " 0\n";
+    else
+      out << "No solution\n";
+    return out.str();
+  }
+
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  string result;
+  if(cache.enabled() && cache.get(it->second, start, goal, g.version, result))
+  {
+    if(log != NULL)
+      stats = statsline(q.alg, q.start, q.goal, -1, w, *log, since(begin), true);
+    return result;
+  }
+
+  int node = search(it->second, start, goal, g, w);
+  if(log != NULL)
+    stats = statsline(q.alg, q.start, q.goal, node, w, *log, since(begin), false);
+  printrecord(node, w, g, out);
+  result = out.str();
+  if(cache.enabled())
+    cache.put(it->second, start, goal, g.version, result);
+  return result;
+}
+
+// queue of query indices owned by one worker thread
+// the owner takes work from the front, idle workers steal from the back
+class WorkQueue {
+public:
+  bool pop(int& q)
+  {
+    lock_guard<mutex> lock(m);
+    if(items.empty())
+      return false;
+    q = items.front();
+    items.pop_front();
+    return true;
+  }
+
+  bool steal(int& q)
+  {
+    lock_guard<mutex> lock(m);
+    if(items.empty())
+      return false;
+    q = items.back();
+    items.pop_back();
+    return true;
+  }
+
+  deque<int> items;
+  mutex m;
+};
+
+// runs batches of independent tasks on a pool of worker threads
+// the graph is shared read-only. workers are started once and wait
+// between batches, and every worker has its own workspace that is kept
+// from batch to batch. task i stores its result by index, so results
+// come out in input order however the work was spread
+class Executor {
+public:
+  Executor(int threads) : spaces(max(threads, 1)), queues(max(threads, 1)), task(NULL), generation(0), busy(0), stop(false)
+  {
+    if(spaces.size() > 1)
+    {
+      // the workers already fill the cores, DELTA stays on its worker
+      for(int t = 0; t < spaces.size(); t++)
+      {
+        spaces[t].threads = 1;
+        workers.push_back(thread(&Executor::work, this, t));
+      }
+    }
+  }
+
+  ~Executor()
+  {
+    {
+      lock_guard<mutex> lock(m);
+      stop = true;
+    }
+    wake.notify_all();
+    for(int t = 0; t < workers.size(); t++)
+      workers[t].join();
+  }
+
+  // calls task(i, workspace) for every i below count
+  void run(int count, const function<void(int, Workspace&)>& task)
+  {
+    int n = spaces.size();
+
+    if(n == 1)
+    {
+      for(int i = 0; i < count; i++)
+        task(i, spaces[0]);
+      return;
+    }
+    if(count == 0)
+      return;
+
+    // each worker starts with a contiguous block of tasks
+    for(int t = 0; t < n; t++)
+    {
+      lock_guard<mutex> lock(queues[t].m);
+      queues[t].items.clear();
+      for(int i = (long) count * t / n; i < (long) count * (t + 1) / n; i++)
+        queues[t].items.push_back(i);
+    }
+
+    unique_lock<mutex> lock(m);
+    this->task = &task;
+    busy = n;
+    generation++;
+    wake.notify_all();
+    done.wait(lock, [&] { return busy == 0; });
+    this->task = NULL;
+  }
+
+private:
+  // waits for a batch, runs tasks from own queue, then steals from the
+  // others. no work is added once a batch starts, so a worker is done
+  // with it when every queue is empty
+  void work(int t)
+  {
+    int n = spaces.size();
+    int seen = 0;
+    while(true)
+    {
+      {
+        unique_lock<mutex> lock(m);
+        wake.wait(lock, [&] { return stop || generation != seen; });
+        if(stop)
+          return;
+        seen = generation;
+      }
+
+      int q;
+      while(true)
+      {
+        bool found = queues[t].pop(q);
+        for(int i = 1; !found && i < n; i++)
+          found = queues[(t + i) % n].steal(q);
+        if(!found)
+          break;
+        (*task)(q, spaces[t]);
+      }
+
+      lock_guard<mutex> lock(m);
+      if(--busy == 0)
+        done.notify_one();
+    }
+  }
+
+  vector<Workspace> spaces;
+  vector<WorkQueue> queues;
+  vector<thread> workers;
+  const function<void(int, Workspace&)>* task; // task of the running batch
+  int generation; // batches started
+  int busy; // workers not yet done with the running batch
+  bool stop;
+  mutex m;
+  condition_variable wake; // a batch started or the pool stops
+  condition_variable done; // last worker finished the batch
+};
+
+// true if another query can be read from in without waiting for input.
+// whitespace that has already arrived is skipped
+bool ready(istream& in)
+{
+  streambuf* buf = in.rdbuf();
+  while(buf->in_avail() > 0)
+  {
+    if(!isspace(buf->sgetc()))
+      return true;
+    buf->sbumpc();
+  }
+  return false;
+}
+
+// batch mode. graph is loaded once, then each line "ALG START GOAL"
+// read from in is answered with one line written to out
+// the queries that have arrived (up to CHUNK) are answered together in
+// parallel, written in order and flushed, so answers never wait for
+// queries that were not sent yet.
+// a line "UPDATE A B COST" sets the live cost of road A to B once every
+// query before it is answered; it writes nothing. malformed lines and
+// negative costs are reported to standard error and ignored.
+// repeated queries are served from a cache of cachebytes bytes (0 for
+// none), whose hit and miss counts go to standard error at the end.
+// with log, one stats line per query is written to it in query order
+void batch(istream& in, ostream& out, Graph& g, map<string, int>& algorithms, int threads, long long cachebytes, StatsLog* log)
+{
+  const int CHUNK = 65536; // most queries answered together
+  Executor executor(threads);
+  ResultCache cache(cachebytes);
+  vector<Query> queries;
+  vector<string> results;
+  vector<string> stats;
+  Query q;
+
+  while(in)
+  {
+    queries.clear();
+    bool update = false;
+    string a, b;
+    int c;
+    // waits for one query, then takes those already waiting
+    while(queries.size() < CHUNK && (queries.empty() || ready(in)) && in >> q.alg)
+    {
+      if(q.alg == "UPDATE")
+      {
+        // parsed from the rest of the line, so a malformed one is
+        // reported and skipped instead of ending the input
+        string line;
+        getline(in, line);
+        istringstream words(line);
+        update = static_cast<bool>(words >> a >> b >> c);
+        if(!update)
+          cerr << "Malformed line UPDATE" << line << "\n";
+        else if(c < 0)
+        {
+          cerr << "Negative cost " << c << " for road " << a << " " << b << "\n";
+          update = false;
+        }
+        break;
+      }
+      if(!(in >> q.start >> q.goal))
+        break;
+      queries.push_back(q);
+    }
+
+    results.assign(queries.size(), "");
+    stats.assign(queries.size(), "");
+    executor.run(queries.size(), [&](int i, Workspace& w) {
+      results[i] = answer(queries[i], g, algorithms, w, cache, log, stats[i]);
+    });
+    for(int i = 0; i < results.size(); i++)
+      out << results[i];
+    out.flush();
+    if(log != NULL)
+    {
+      for(int i = 0; i < stats.size(); i++)
+        *log->os << stats[i];
+      log->os->flush();
+    }
+
+    // no search is running, so the graph can change here
+    if(update)
+    {
+      int from = g.find(a);
+      int to = g.find(b);
+      int e = from == -1 || to == -1 ? -1 : g.findedge(from, to);
+      if(e == -1)
+        cerr << "No road from " << a << " to " << b << "\n";
+      else
+        g.setweight(e, c);
+    }
+  }
+
+  if(cache.enabled())
+    cerr << "cache hits " << cache.hits << " misses " << cache.misses << "\n";
+}
+
+// one-to-many request: a source and the goals to report on
+struct TreeQuery {
+  string start;
+  vector<string> goals;
+};
+
+// answers one-to-many query q, one record per goal in goal order
+// followed by an empty line
+string answertree(TreeQuery& q, Graph& g, Workspace& w)
+{
+  ostringstream out;
+  int start = g.find(q.start);
+  vector<int> goals(q.goals.size());
+  for(int i = 0; i < q.goals.size(); i++)
+    goals[i] = g.find(q.goals[i]);
+
+  if(start != -1)
+    tree(start, goals, g, w);
+
+  for(int i = 0; i < goals.size(); i++)
+  {
+    if(start == -1 || goals[i] == -1)
+    {
+      if(q.start == q.goals[i])
+        out << q.start << " 0\n";
+      else
+        out << "No solution\n";
+    }
+    else
+      printrecord(settled(goals[i], w), w, g, out);
+  }
+  out << "\n";
+
+  return out.str();
+}
+
+// one-to-many mode. each line "START GOAL1 GOAL2 ..." read from in is
+// answered with one shortest-path tree from START and written to out as
+// one record per goal, followed by an empty line. lines run in parallel
+void trees(istream& in, ostream& out, Graph& g, int threads)
+{
+  const int CHUNK = 4096;
+  Executor executor(threads);
+  vector<TreeQuery> queries;
+  vector<string> results;
+  string line;
+
+  while(in)
+  {
+    queries.clear();
+    while(queries.size() < CHUNK && getline(in, line))
+    {
+      istringstream words(line);
+      TreeQuery q;
+      if(!(words >> q.start))
+        continue;
+      string goal;
+      while(words >> goal)
+        q.goals.push_back(goal);
+      queries.push_back(q);
+    }
+
+    results.assign(queries.size(), "");
+    executor.run(queries.size(), [&](int i, Workspace& w) {
+      results[i] = answertree(queries[i], g, w);
+    });
+    for(int i = 0; i < results.size(); i++)
+      out << results[i];
+  }
+}
+
+// many-to-many mode. in holds a line of source locations and a line of
+// target locations. one shortest-path tree is grown per source, sources
+// in parallel, and out gets a compact cost matrix: a header line with
+// the targets, then one line per source with its cost to each target,
+// -1 where there is no route
+void matrix(istream& in, ostream& out, Graph& g, int threads)
+{
+  vector<string> names[2];
+  string line;
+  for(int i = 0; i < 2 && getline(in, line); i++)
+  {
+    istringstream words(line);
+    string name;
+    while(words >> name)
+      names[i].push_back(name);
+  }
+  vector<string>& sources = names[0];
+  vector<string>& targets = names[1];
+
+  vector<int> ids(targets.size());
+  for(int j = 0; j < targets.size(); j++)
+    ids[j] = g.find(targets[j]);
+
+  vector<int> costs(sources.size() * targets.size(), -1);
+  Executor executor(threads);
+  executor.run(sources.size(), [&](int i, Workspace& w) {
+    int start = g.find(sources[i]);
+    if(start != -1)
+      tree(start, ids, g, w);
+    for(int j = 0; j < targets.size(); j++)
+    {
+      if(start != -1 && ids[j] != -1 && w.fcost.cost(ids[j]) < INF)
+        costs[i * targets.size() + j] = w.fcost.cost(ids[j]);
+      else if(sources[i] == targets[j])
+        costs[i * targets.size() + j] = 0;
+    }
+  });
+
+  out << "-";
+  for(int j = 0; j < targets.size(); j++)
+    out << " " << targets[j];
+  out << "\n";
+  for(int i = 0; i < sources.size(); i++)
+  {
+    out << sources[i];
+    for(int j = 0; j < targets.size(); j++)
+      out << " " << costs[i * targets.size() + j];
+    out << "\n";
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  // results are written through cout only, its own buffer saves a
+  // write per line in batch mode
+  ios::sync_with_stdio(false);
+
+  string alg;
+  string start;
+  string goal;
+  Graph graph;
+  map<string, int> algorithms = { {"BFS", 0}, {"DFS", 1}, {"UCS", 2}, {"A*", 3}, {"ALT", 4}, {"CH", 5}, {"BIUCS", 6}, {"BIA*", 7}, {"DELTA", 8}, {"IDA*", 9}, {"IDDFS", 10} };
+  bool batchmode = false;
+  bool replanmode = false;
+  bool treemode = false;
+  const char* treefile = NULL;
+  const char* matrixfile = NULL;
+  const char* deltafile = NULL;
+  const char* queryfile = NULL;
+  const char* graphfile = NULL;
+  const char* landmarkfile = NULL;
+  const char* landmarkout = NULL;
+  int landmarkcount = 0;
+  Landmarks landmarks;
+  const char* hierarchyfile = NULL;
+  const char* hierarchyout = NULL;
+  const char* heuristicfile = NULL;
+  const char* heuristicgoals = NULL;
+  const char* heuristicout = NULL;
+  GoalTables goaltables;
+  Hierarchy hierarchy;
+  const char* convertin = NULL;
+  const char* convertout = NULL;
+  string generatestyle;
+  long long generateedges = 0;
+  const char* generatefile = NULL;
+  long long benchedges = 0;
+  unsigned seed = 1;
+  int threads = max((int) thread::hardware_concurrency(), 1);
+  long long cachebytes = 64LL * 1024 * 1024;
+  bool statsmode = false;
+  const char* statsfile = NULL;
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "--batch")
+    {
+      batchmode = true;
+      if(i + 1 < argc && argv[i + 1][0] != '-')
+        queryfile = argv[++i];
+    }
+    else if(arg == "--replan")
+    {
+      replanmode = true;
+      if(i + 1 < argc && argv[i + 1][0] != '-')
+        deltafile = argv[++i];
+    }
+    else if(arg == "--tree")
+    {
+      treemode = true;
+      if(i + 1 < argc && argv[i + 1][0] != '-')
+        treefile = argv[++i];
+    }
+    else if(arg == "--stats")
+    {
+      statsmode = true;
+      if(i + 1 < argc && argv[i + 1][0] != '-')
+        statsfile = argv[++i];
+    }
+    else if(arg == "--matrix" && i + 1 < argc)
+      matrixfile = argv[++i];
+    else if(arg == "--threads" && i + 1 < argc)
+      threads = atoi(argv[++i]);
+    else if(arg == "--delta" && i + 1 < argc)
+      OPTIONS.delta = atoi(argv[++i]);
+    else if(arg == "--cache" && i + 1 < argc)
+      cachebytes = atoll(argv[++i]) * 1024 * 1024;
+    else if(arg == "--memory" && i + 1 < argc)
+      OPTIONS.memory = atoll(argv[++i]) * 1024 * 1024;
+    else if(arg == "--graph" && i + 1 < argc)
+      graphfile = argv[++i];
+    else if(arg == "--landmarks" && i + 1 < argc)
+      landmarkfile = argv[++i];
+    else if(arg == "--heuristics" && i + 1 < argc)
+      heuristicfile = argv[++i];
+    else if(arg == "--build-heuristics" && i + 2 < argc)
+    {
+      heuristicgoals = argv[++i];
+      heuristicout = argv[++i];
+    }
+    else if(arg == "--ch" && i + 1 < argc)
+      hierarchyfile = argv[++i];
+    else if(arg == "--build-ch" && i + 1 < argc)
+      hierarchyout = argv[++i];
+    else if(arg == "--build-landmarks" && i + 2 < argc)
+    {
+      landmarkcount = atoi(argv[++i]);
+      landmarkout = argv[++i];
+    }
+    else if(arg == "--generate" && i + 3 < argc)
+    {
+      generatestyle = argv[++i];
+      generateedges = atoll(argv[++i]);
+      generatefile = argv[++i];
+    }
+    else if(arg == "--bench")
+    {
+      benchedges = 10000000;
+      if(i + 1 < argc && argv[i + 1][0] != '-')
+        benchedges = atoll(argv[++i]);
+    }
+    else if(arg == "--seed" && i + 1 < argc)
+      seed = strtoul(argv[++i], NULL, 10);
+    else if(arg == "--convert" && i + 2 < argc)
+    {
+      convertin = argv[++i];
+      convertout = argv[++i];
+    }
+    else
+    {
+      cerr << "Unknown option " << arg << "\n";
+      return 1;
+    }
+  }
+
+  if(generatefile != NULL)
+    return writegraph(generatestyle, generateedges, seed, generatefile) ? 0 : 1;
+
+  if(benchedges > 0)
+  {
+    OPTIONS.threads = threads;
+    return bench(benchedges, seed, cout) ? 0 : 1;
+  }
+
+  if(convertin != NULL)
+  {
+    if(!load(convertin, alg, start, goal, graph))
+    {
+      cerr << "Cannot open " << convertin << "\n";
+      return 1;
+    }
+    if(!graph.save(convertout))
+    {
+      cerr << "Cannot write " << convertout << "\n";
+      return 1;
+    }
+    return 0;
+  }
+
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  if(graphfile != NULL)
+  {
+    // a binary graph holds no query, so it only serves batch mode
+    if(!batchmode && !treemode && matrixfile == NULL && landmarkout == NULL && hierarchyout == NULL && heuristicout == NULL)
+    {
+      cerr << "--graph needs --batch, --tree or --matrix\n";
+      return 1;
+    }
+    if(!graph.open(graphfile))
+    {
+      cerr << "Cannot open graph " << graphfile << "\n";
+      return 1;
+    }
+  }
+  else if(!load("input.txt", alg, start, goal, graph))
+  {
+    cerr << "Cannot open input.txt\n";
+    return 1;
+  }
+
+  ofstream statsout;
+  StatsLog log = { &cerr, since(begin) };
+  if(statsfile != NULL)
+  {
+    statsout.open(statsfile, std::ofstream::out | std::ofstream::trunc);
+    if(!statsout.is_open())
+    {
+      cerr << "Cannot write " << statsfile << "\n";
+      return 1;
+    }
+    log.os = &statsout;
+  }
+  StatsLog* logp = statsmode ? &log : NULL;
+
+  if(landmarkout != NULL)
+  {
+    buildlandmarks(graph, landmarkcount, landmarks);
+    if(!landmarks.save(landmarkout))
+    {
+      cerr << "Cannot write " << landmarkout << "\n";
+      return 1;
+    }
+    return 0;
+  }
+
+  if(hierarchyout != NULL)
+  {
+    hierarchy.build(graph);
+    if(!hierarchy.save(hierarchyout))
+    {
+      cerr << "Cannot write " << hierarchyout << "\n";
+      return 1;
+    }
+    return 0;
+  }
+
+  if(hierarchyfile != NULL)
+  {
+    if(!hierarchy.open(hierarchyfile, graph))
+    {
+      cerr << "Cannot open hierarchy " << hierarchyfile << " for this graph\n";
+      return 1;
+    }
+    graph.hierarchy = &hierarchy;
+  }
+
+  if(landmarkfile != NULL)
+  {
+    if(!landmarks.open(landmarkfile, graph.size(), graph.edges, graph.checksum()))
+    {
+      cerr << "Cannot open landmarks " << landmarkfile << " for this graph\n";
+      return 1;
+    }
+    landmarks.version = graph.version;
+    graph.landmarks = &landmarks;
+  }
+
+  if(heuristicfile != NULL)
+  {
+    if(!goaltables.open(heuristicfile, graph))
+    {
+      cerr << "Cannot open heuristics " << heuristicfile << "\n";
+      return 1;
+    }
+    graph.goaltables = &goaltables;
+  }
+
+  if(heuristicout != NULL)
+    return buildheuristics(graph, heuristicgoals, heuristicout) ? 0 : 1;
+  OPTIONS.threads = threads;
+
+  if(batchmode)
+  {
+    if(queryfile != NULL)
+    {
+      ifstream queries(queryfile);
+      if(!queries.is_open())
+      {
+        cerr << "Cannot open " << queryfile << "\n";
+        return 1;
+      }
+      batch(queries, cout, graph, algorithms, threads, cachebytes, logp);
+    }
+    else
+      batch(cin, cout, graph, algorithms, threads, cachebytes, logp);
+    return 0;
+  }
+
+  if(treemode)
+  {
+    if(treefile != NULL)
+    {
+      ifstream queries(treefile);
+      if(!queries.is_open())
+      {
+        cerr << "Cannot open " << treefile << "\n";
+        return 1;
+      }
+      trees(queries, cout, graph, threads);
+    }
+    else
+      trees(cin, cout, graph, threads);
+    return 0;
+  }
+
+  if(matrixfile != NULL)
+  {
+    ifstream locations(matrixfile);
+    if(!locations.is_open())
+    {
+      cerr << "Cannot open " << matrixfile << "\n";
+      return 1;
+    }
+    matrix(locations, cout, graph, threads);
+    return 0;
+  }
+
+  if(replanmode)
+  {
+    // UCS unless input.txt asks for A*
+    bool b = alg == "A*";
+    if(deltafile != NULL)
+    {
+      ifstream deltas(deltafile);
+      if(!deltas.is_open())
+      {
+        cerr << "Cannot open " << deltafile << "\n";
+        return 1;
+      }
+      replan(deltas, cout, graph, graph.find(start), graph.find(goal), b);
+    }
+    else
+      replan(cin, cout, graph, graph.find(start), graph.find(goal), b);
+    return 0;
+  }
+
+  Workspace w;
+  begin = chrono::steady_clock::now();
+  int node = search(algorithms[alg], graph.find(start), graph.find(goal), graph, w);
+  if(logp != NULL)
+    *log.os << statsline(alg, start, goal, node, w, log, since(begin), false);
+
+  if(node == -1)
+    cout << "No solution \n";
+  else
+    printout(node, w, graph);
+
   return 0;
 }
@@ -9,6 +9,16 @@
    between sum of values of all squares occupied by player and
    sum of values of all squares occupied by enemy. Program prints
    column, row, move, and board after making move in output.txt.
+   Boards up to 26x26 are supported.
+
+   main.exe --tt MB remembers searched positions in a
+   transposition table of MB megabytes (default 16, 0 turns
+   it off), so positions reached by different move orders
+   are only searched once.
+
+   --time MS ignores the depth limit of input.txt and searches
+   depth 1, 2, 3, ... until MS milliseconds have passed, then
+   prints the best move of the deepest search that finished.
 */
 #include <iostream>
 #include <string>
@@ -16,363 +26,705 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <map>
+#include <random>
+#include <cstdlib>
+#include <chrono>
 
 using namespace std;
 
 ofstream ofs;
 
-string PLAYER;
-string ENEMY;
+const int X = 0;
+const int O = 1;
+const char SYMBOL[] = "XO";
+
+int PLAYER;
+int ENEMY;
+
+const int MAXN = 26; // largest board side
+const int WORDS = (MAXN * MAXN + 63) / 64;
+
+// set of squares as a multi-word bitmask. bit i is square i, counted
+// row by row from the top left
+class Bits {
+public:
+  Bits() {
+    for(int k = 0; k < WORDS; k++)
+      w[k] = 0;
+  }
+
+  bool test(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+  void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+  void reset(int i) { w[i >> 6] &= ~(1ULL << (i & 63)); }
+
+  Bits operator|(const Bits& b) const
+  {
+    Bits r;
+    for(int k = 0; k < WORDS; k++)
+      r.w[k] = w[k] | b.w[k];
+    return r;
+  }
+
+  Bits operator&(const Bits& b) const
+  {
+    Bits r;
+    for(int k = 0; k < WORDS; k++)
+      r.w[k] = w[k] & b.w[k];
+    return r;
+  }
+
+  Bits operator~() const
+  {
+    Bits r;
+    for(int k = 0; k < WORDS; k++)
+      r.w[k] = ~w[k];
+    return r;
+  }
+
+  bool operator==(const Bits& b) const
+  {
+    for(int k = 0; k < WORDS; k++)
+    {
+      if(w[k] != b.w[k])
+        return false;
+    }
+    return true;
+  }
+
+  // moves every square s to s + c, 0 < c < 64
+  Bits operator<<(int c) const
+  {
+    Bits r;
+    for(int k = WORDS - 1; k > 0; k--)
+      r.w[k] = (w[k] << c) | (w[k - 1] >> (64 - c));
+    r.w[0] = w[0] << c;
+    return r;
+  }
+
+  // moves every square s to s - c, 0 < c < 64
+  Bits operator>>(int c) const
+  {
+    Bits r;
+    for(int k = 0; k < WORDS - 1; k++)
+      r.w[k] = (w[k] >> c) | (w[k + 1] << (64 - c));
+    r.w[WORDS - 1] = w[WORDS - 1] >> c;
+    return r;
+  }
+
+  // lowest square at or after i, -1 if there is none
+  int next(int i) const
+  {
+    for(int k = i >> 6; k < WORDS; k++)
+    {
+      unsigned long long m = w[k];
+      if(k == i >> 6)
+        m &= ~0ULL << (i & 63);
+      if(m != 0)
+        return (k << 6) + __builtin_ctzll(m);
+    }
+    return -1;
+  }
+
+  unsigned long long w[WORDS];
+};
+
+// kinds of move, as printed in output.txt
+const int NOMOVE = 0;
+const int STAKE = 1;
+const int RAID = 2;
+const char* MOVES[] = { "", "Stake", "Raid" };
+
+int N; // board is N x N
+Bits FULL; // every square of the board
+Bits LEFT; // squares with a neighbour to the left
+Bits RIGHT; // squares with a neighbour to the right
+
+// random key of each side on each square. the key of a position is the
+// xor of the keys of its pieces. the side to move needs no key: every
+// move fills one empty square, so it follows from the empty squares left
+unsigned long long ZOBRIST[2][MAXN * MAXN];
+
+// sets up board masks and square keys for an n x n board
+void setsize(int n)
+{
+  N = n;
+  FULL = LEFT = RIGHT = Bits();
+  for(int i = 0; i < n * n; i++)
+  {
+    FULL.set(i);
+    if(i % n != 0)
+      LEFT.set(i);
+    if((i + 1) % n != 0)
+      RIGHT.set(i);
+  }
+
+  mt19937_64 rng(512);
+  for(int i = 0; i < MAXN * MAXN; i++)
+  {
+    ZOBRIST[X][i] = rng();
+    ZOBRIST[O][i] = rng();
+  }
+}
+
+// squares next to some square of m, vertically or horizontally
+Bits neighbours(const Bits& m)
+{
+  return ((m & LEFT) >> 1) | ((m & RIGHT) << 1) | (m >> N) | ((m << N) & FULL);
+}
 
 class Board {
 public:
   Board() {
     index = -1;
-    move = "";
-    dir = "";
-    temp = -999;
-    temp2 = -999;
+    move = NOMOVE;
+    sums[X] = 0;
+    sums[O] = 0;
+    empties = 0;
+    key = 0;
   }
 
+  // recomputes sums, empties and key from pieces, after the board is read
+  void recount()
+  {
+    sums[X] = 0;
+    sums[O] = 0;
+    empties = 0;
+    key = 0;
+    for(int i = 0; i < size(); i++)
+    {
+      if(pieces[X].test(i))
+      {
+        sums[X] += values[i];
+        key ^= ZOBRIST[X][i];
+      }
+      else if(pieces[O].test(i))
+      {
+        sums[O] += values[i];
+        key ^= ZOBRIST[O][i];
+      }
+      else
+        empties++;
+    }
+  }
+
+  bool isempty(int i) const { return !pieces[X].test(i) && !pieces[O].test(i); }
+  Bits empty() const { return FULL & ~(pieces[X] | pieces[O]); }
+  int size() const { return N * N; }
+
   vector<int> values; // value of each square
-  vector<string> states; // which square is occupied by which player
-  int index; // square on board that achieves highest score
-  string move; // best move player can make to achieve highest score. either Stake or Raid
-  string dir; // direction to raid to achieve highest score
-  int temp; // highest score player has achieved. used in raid function
-  int temp2; // highest score player has achieved. used in minimax and alphabeta
+  Bits pieces[2]; // squares occupied by X and by O
+  int sums[2]; // values of squares occupied by X and by O, kept up to date by moves
+  int empties; // number of unoccupied squares
+  unsigned long long key; // zobrist key of pieces, kept up to date by moves
+  int index; // square the best move places a piece on
+  int move; // best move player can make to achieve highest score. either STAKE or RAID
 };
 
 // returns current score of player
-int calculateScore(Board b)
+int calculateScore(const Board& b)
 {
-  int score = 0;
-  int enemyScore = 0;
-  for(int i = 0; i < b.states.size(); i++)
-  {
-    if(b.states[i] == PLAYER)
-      score += b.values[i];
-    if(b.states[i] != PLAYER && b.states[i] != ".")
-      enemyScore += b.values[i];
-  }
+  return b.sums[PLAYER] - b.sums[ENEMY];
+}
 
-  return score - enemyScore;
+// what a move changed, so it can be taken back without copying the board
+class Undo {
+public:
+  int player;
+  int square; // square the piece was placed on
+  int conquered[4]; // squares taken from the enemy
+  int count; // number of conquered squares
+};
+
+// takes square s from the enemy of player
+void take(Board& b, int player, int s, Undo& undo)
+{
+  b.pieces[1 - player].reset(s);
+  b.pieces[player].set(s);
+  b.sums[1 - player] -= b.values[s];
+  b.sums[player] += b.values[s];
+  b.key ^= ZOBRIST[1 - player][s] ^ ZOBRIST[player][s];
+  undo.conquered[undo.count++] = s;
 }
 
 // conquers adjacent squares
-Board conquer(Board b, string player, int i, int j)
+void conquer(Board& b, int player, int i, int j, Undo& undo)
 {
-  if(i - 1 >= 0 && (i % j) != 0 && b.states[i - 1] != player && b.states[i - 1] != ".") // conquers square left of raided square
-    b.states[i - 1] = player;
-  if(i + 1 < b.states.size() && ((i + 1) % j) != 0 && b.states[i + 1] != player && b.states[i + 1] != ".") // conquers square right of raided square
-    b.states[i + 1] = player;
-  if(i - j >= 0 && b.states[i - j] != player && b.states[i - j] != ".") // conquers square above raided square
-    b.states[i - j] = player;
-  if(i + j < b.states.size() && b.states[i + j] != player && b.states[i + j] != ".") // conquers square below raided square
-    b.states[i + j] = player;
-
-  return b;
+  int enemy = 1 - player;
+  if(i - 1 >= 0 && (i % j) != 0 && b.pieces[enemy].test(i - 1)) // conquers square left of raided square
+    take(b, player, i - 1, undo);
+  if(i + 1 < b.size() && ((i + 1) % j) != 0 && b.pieces[enemy].test(i + 1)) // conquers square right of raided square
+    take(b, player, i + 1, undo);
+  if(i - j >= 0 && b.pieces[enemy].test(i - j)) // conquers square above raided square
+    take(b, player, i - j, undo);
+  if(i + j < b.size() && b.pieces[enemy].test(i + j)) // conquers square below raided square
+    take(b, player, i + j, undo);
 }
 
-int minimax(Board& b, int depth, int depthLimit, bool isMax, string player);
-int alphabeta(Board& b, int depth, int depthLimit, bool isMax, string player, int al, int bt);
+// places a piece of player on empty square s, then conquers its
+// neighbours if the move is a raid. undo records what changed
+void makemove(Board& b, int player, int s, bool raid, Undo& undo)
+{
+  undo.player = player;
+  undo.square = s;
+  undo.count = 0;
+
+  b.pieces[player].set(s);
+  b.sums[player] += b.values[s];
+  b.empties--;
+  b.key ^= ZOBRIST[player][s];
+  if(raid)
+    conquer(b, player, s, N, undo);
+}
 
-// raids adjacent squares
-int raid(Board& b, int depth, int depthLimit, bool isMax, string player, int i, bool ab, int al, int bt)
+// takes back the move recorded in undo
+void unmakemove(Board& b, const Undo& undo)
 {
-  int j = sqrt(b.states.size());
-  int l = i - 1;
-  int r = i + 1;
-  int u = i - j;
-  int d = i + j;
-  if(isMax)
-  {
-    int value = -999;
-    if(l >= 0 && (i % j) != 0 && b.states[l] == ".") // raids to the left
+  for(int k = 0; k < undo.count; k++)
+  {
+    int s = undo.conquered[k];
+    b.pieces[undo.player].reset(s);
+    b.pieces[1 - undo.player].set(s);
+    b.sums[undo.player] -= b.values[s];
+    b.sums[1 - undo.player] += b.values[s];
+    b.key ^= ZOBRIST[undo.player][s] ^ ZOBRIST[1 - undo.player][s];
+  }
+  b.pieces[undo.player].reset(undo.square);
+  b.sums[undo.player] -= b.values[undo.square];
+  b.empties++;
+  b.key ^= ZOBRIST[undo.player][undo.square];
+}
+
+// kinds of remembered score
+const int EXACT = 0;
+const int LOWER = 1; // true score is at least this
+const int UPPER = 2; // true score is at most this
+
+// a position searched before
+class Entry {
+public:
+  Entry() {
+    key = 0;
+    score = 0;
+    move = -1;
+    depth = 0;
+    bound = EXACT;
+  }
+
+  unsigned long long key;
+  int score;
+  short move; // best move found there, -1 if none
+  unsigned char depth; // plies searched below the position, 0 if unused
+  unsigned char bound; // EXACT, LOWER or UPPER
+};
+
+const int BUCKET = 4; // entries in one 64 byte cache line
+
+// transposition table: positions already searched, with their scores.
+// the key of a position picks one bucket of BUCKET entries, and a new
+// position replaces the one searched least deep
+class Table {
+public:
+  Table() {
+    table = NULL;
+    mask = 0;
+  }
+
+  // uses about bytes of memory, a power of two buckets. 0 turns it off
+  void resize(long long bytes)
+  {
+    long long buckets = 0;
+    if(bytes >= (long long) (BUCKET * sizeof(Entry)))
     {
-      Board save = b;
-      b.states[l] = player;
-      b = conquer(b, player, l, j);
-      if(ab)
-        value = max(value, alphabeta(b, depth + 1, depthLimit, false, ENEMY, al, bt));
-      else
-        value = max(value, minimax(b, depth + 1, depthLimit, false, ENEMY));
-      b = save;
-      if(value > b.temp)
-      {
-        b.temp = value;
-        b.dir = "l";
-      }
+      buckets = 1;
+      while(buckets * 2 * BUCKET * sizeof(Entry) <= bytes)
+        buckets *= 2;
     }
-    if(r < b.states.size() && ((i + 1) % j) != 0 && b.states[r] == ".") // raids to the right
+    entries.assign(buckets * BUCKET + BUCKET - 1, Entry());
+    table = NULL;
+    mask = 0;
+    if(buckets > 0)
     {
-      Board save = b;
-      b.states[r] = player;
-      b = conquer(b, player, r, j);
-      if(ab)
-        value = max(value, alphabeta(b, depth + 1, depthLimit, false, ENEMY, al, bt));
-      else
-        value = max(value, minimax(b, depth + 1, depthLimit, false, ENEMY));
-      b = save;
-      if(value > b.temp)
-      {
-        b.temp = value;
-        b.dir = "r";
-      }
+      // skip entries until the first bucket starts a cache line
+      table = &entries[0];
+      while((reinterpret_cast<size_t>(table) & 63) != 0)
+        table++;
+      mask = buckets - 1;
     }
-    if(u >= 0 && b.states[u] == ".") // raids above
+  }
+
+  // entry of the position with this key, NULL if it was not searched
+  Entry* probe(unsigned long long key)
+  {
+    if(table == NULL)
+      return NULL;
+    Entry* bucket = table + (key & mask) * BUCKET;
+    for(int k = 0; k < BUCKET; k++)
     {
-      Board save = b;
-      b.states[u] = player;
-      b = conquer(b, player, u, j);
-      if(ab)
-        value = max(value, alphabeta(b, depth + 1, depthLimit, false, ENEMY, al, bt));
-      else
-        value = max(value, minimax(b, depth + 1, depthLimit, false, ENEMY));
-      b = save;
-      if(value > b.temp)
-      {
-        b.temp = value;
-        b.dir = "u";
-      }
+      if(bucket[k].key == key && bucket[k].depth > 0)
+        return &bucket[k];
     }
-    if(d < b.states.size() && b.states[d] == ".") // raids below
+    return NULL;
+  }
+
+  void store(unsigned long long key, int depth, int bound, int score, int move)
+  {
+    if(table == NULL)
+      return;
+    Entry* bucket = table + (key & mask) * BUCKET;
+    Entry* e = &bucket[0];
+    for(int k = 0; k < BUCKET; k++)
     {
-      Board save = b;
-      b.states[d] = player;
-      b = conquer(b, player, d, j);
-      if(ab)
-        value = max(value, alphabeta(b, depth + 1, depthLimit, false, ENEMY, al, bt));
-      else
-        value = max(value, minimax(b, depth + 1, depthLimit, false, ENEMY));
-      b = save;
-      if(value > b.temp)
+      if(bucket[k].key == key)
       {
-        b.temp = value;
-        b.dir = "d";
+        e = &bucket[k];
+        break;
       }
+      if(bucket[k].depth < e->depth)
+        e = &bucket[k];
     }
-    return value;
-  } else {
-    int value = 999;
-    if(l >= 0 && (i % j) != 0 && b.states[l] == ".") // raids to the left
-    {
-      Board save = b;
-      b.states[l] = player;
-      b = conquer(b, player, l, j);
-      if(ab)
-        value = min(value, alphabeta(b, depth + 1, depthLimit, true, PLAYER, al, bt));
-      else
-        value = min(value, minimax(b, depth + 1, depthLimit, true, PLAYER));
-      b = save;
-    }
-    if(r < b.states.size() && ((i + 1) % j) != 0 && b.states[r] == ".") // raids to the right
-    {
-      Board save = b;
-      b.states[r] = player;
-      b = conquer(b, player, r, j);
-      if(ab)
-        value = min(value, alphabeta(b, depth + 1, depthLimit, true, PLAYER, al, bt));
-      else
-        value = min(value, minimax(b, depth + 1, depthLimit, true, PLAYER));
-      b = save;
-    }
-    if(u >= 0 && b.states[u] == ".") // raids above
+    e->key = key;
+    e->score = score;
+    e->move = move;
+    e->depth = min(depth, 255);
+    e->bound = bound;
+  }
+
+  vector<Entry> entries;
+  Entry* table; // first bucket, aligned to a cache line
+  unsigned long long mask; // number of buckets - 1
+};
+
+Table TABLE;
+
+// checks if every square is occupied
+bool terminalstate(const Board& b)
+{
+  return b.empties == 0;
+}
+
+// prints the board
+void printboard(const Board& b)
+{
+  int j = N;
+  for(int i = 0; i < b.size(); i++)
+  {
+    if(i % j == 0) ofs << endl;
+    if(b.pieces[X].test(i))
+      ofs << SYMBOL[X];
+    else if(b.pieces[O].test(i))
+      ofs << SYMBOL[O];
+    else
+      ofs << ".";
+  }
+  ofs << endl;
+}
+
+// squares worth trying in index order: empty squares can be staked,
+// own squares next to an empty one can raid. other squares change
+// nothing in minimax and alphabeta
+Bits candidates(const Board& b, int player)
+{
+  Bits empty = b.empty();
+  return empty | (b.pieces[player] & neighbours(empty));
+}
+
+// most moves a position can have: a stake and a raid on every square
+const int MAXMOVES = 2 * MAXN * MAXN;
+
+// a move is the square its piece is placed on times 2, plus 1 for a raid
+int squareof(int m) { return m / 2; }
+bool israid(int m) { return m % 2 == 1; }
+
+// fills moves with the moves of player and returns how many there are.
+// squares are taken in index order, a stake on an empty square and raids
+// from an own square to the left, right, above and below. a raid on a
+// square that was already raided from another square is left out, it
+// ends in the same position
+int generatemoves(const Board& b, int player, int* moves)
+{
+  int count = 0;
+  Bits raided;
+  Bits squares = candidates(b, player);
+  for(int i = squares.next(0); i != -1; i = squares.next(i + 1))
+  {
+    if(b.isempty(i))
     {
-      Board save = b;
-      b.states[u] = player;
-      b = conquer(b, player, u, j);
-      if(ab)
-        value = min(value, alphabeta(b, depth + 1, depthLimit, true, PLAYER, al, bt));
-      else
-        value = min(value, minimax(b, depth + 1, depthLimit, true, PLAYER));
-      b = save;
+      moves[count++] = i * 2;
+      continue;
     }
-    if(d < b.states.size() && b.states[d] == ".") // raids below
+    int targets[4] = { i % N != 0 ? i - 1 : -1, (i + 1) % N != 0 ? i + 1 : -1, i - N, i + N };
+    for(int k = 0; k < 4; k++)
     {
-      Board save = b;
-      b.states[d] = player;
-      b = conquer(b, player, d, j);
-      if(ab)
-        value = min(value, alphabeta(b, depth + 1, depthLimit, true, PLAYER, al, bt));
-      else
-        value = min(value, minimax(b, depth + 1, depthLimit, true, PLAYER));
-      b = save;
+      int t = targets[k];
+      if(t >= 0 && t < b.size() && b.isempty(t) && !raided.test(t))
+      {
+        raided.set(t);
+        moves[count++] = t * 2 + 1;
+      }
     }
-    return value;
   }
-  return 0;
+  return count;
 }
 
-// checks if every square is occupied
-bool terminalstate(Board b)
+// move ordering for alphabeta. moves are tried best scored first:
+// the best move TABLE remembers, raids by the value they conquer,
+// killer moves, then other moves by how often they caused a cutoff
+const int HASHSCORE = 1 << 30;
+const int RAIDSCORE = 1 << 26; // plus the value conquered
+const int KILLERSCORE = 1 << 24;
+
+const int MAXPLY = MAXN * MAXN + 1; // a game never lasts longer
+int KILLERS[MAXPLY][2]; // last two moves without conquests that cut off at each ply
+int HISTORY[2][MAXMOVES]; // cutoffs each side's moves caused, weighted by depth
+
+// forgets killer moves and history
+void resetorder()
 {
-  for(int i = 0; i < b.states.size(); i++)
+  for(int d = 0; d < MAXPLY; d++)
   {
-    if(b.states[i] == ".") return false;
+    KILLERS[d][0] = -1;
+    KILLERS[d][1] = -1;
   }
+  for(int m = 0; m < MAXMOVES; m++)
+  {
+    HISTORY[X][m] = 0;
+    HISTORY[O][m] = 0;
+  }
+}
 
-  return true;
+// value of the enemy squares a raid of player on square i conquers
+int raidgain(const Board& b, int player, int i)
+{
+  int j = N;
+  int enemy = 1 - player;
+  int gain = 0;
+  if(i % j != 0 && b.pieces[enemy].test(i - 1))
+    gain += b.values[i - 1];
+  if((i + 1) % j != 0 && b.pieces[enemy].test(i + 1))
+    gain += b.values[i + 1];
+  if(i - j >= 0 && b.pieces[enemy].test(i - j))
+    gain += b.values[i - j];
+  if(i + j < b.size() && b.pieces[enemy].test(i + j))
+    gain += b.values[i + j];
+  return gain;
 }
 
-// prints the board
-void printboard(Board b)
+// gives each move of player at ply depth its ordering score
+void scoremoves(const Board& b, int player, int depth, int hashmove, const int* moves, int count, int* scores)
 {
-  int j = sqrt(b.states.size());
-  for(int i = 0; i < b.states.size(); i++)
+  for(int k = 0; k < count; k++)
   {
-    if(i % j == 0) ofs << endl;
-    ofs << b.states[i];
+    int m = moves[k];
+    int gain = israid(m) ? raidgain(b, player, squareof(m)) : 0;
+    if(m == hashmove)
+      scores[k] = HASHSCORE;
+    else if(gain > 0)
+      scores[k] = RAIDSCORE + gain;
+    else if(m == KILLERS[depth][0])
+      scores[k] = KILLERSCORE + 1;
+    else if(m == KILLERS[depth][1])
+      scores[k] = KILLERSCORE;
+    else
+      scores[k] = min(HISTORY[player][m], KILLERSCORE - 1);
   }
-  ofs << endl;
+}
+
+// swaps the best scored of moves k .. count - 1 into place k
+void picknext(int* moves, int* scores, int k, int count)
+{
+  int best = k;
+  for(int i = k + 1; i < count; i++)
+  {
+    if(scores[i] > scores[best])
+      best = i;
+  }
+  swap(moves[k], moves[best]);
+  swap(scores[k], scores[best]);
+}
+
+// remembers move m of player, which conquers nothing, as a cutoff at ply depth
+void cutoff(const Board& b, int player, int depth, int draft, int m)
+{
+  if(israid(m) && raidgain(b, player, squareof(m)) > 0)
+    return;
+  if(KILLERS[depth][0] != m)
+  {
+    KILLERS[depth][1] = KILLERS[depth][0];
+    KILLERS[depth][0] = m;
+  }
+  HISTORY[player][m] += draft * draft;
+}
+
+// timed searches stop once DEADLINE has passed
+chrono::steady_clock::time_point DEADLINE;
+bool TIMED = false; // DEADLINE is in force
+bool STOPPED = false; // DEADLINE passed, the running search is thrown away
+long long NODES = 0; // nodes visited, the clock is read every 1024
+
+// checks whether a timed search has run out of time
+bool timeup()
+{
+  if(TIMED && !STOPPED && (++NODES & 1023) == 0 && chrono::steady_clock::now() >= DEADLINE)
+    STOPPED = true;
+  return STOPPED;
 }
 
 // minimax
-// compares scores achieved from stake and raid
-int minimax(Board& b, int depth, int depthLimit, bool isMax, string player)
+// compares scores achieved from every stake and raid
+// positions reached again are looked up in TABLE
+int minimax(Board& b, int depth, int depthLimit, bool isMax, int player)
 {
   if(depth >= depthLimit || terminalstate(b))
     return calculateScore(b);
 
-  if(isMax)
+  if(timeup())
+    return 0;
+
+  int draft = min(depthLimit - depth, b.empties);
+  Entry* e = TABLE.probe(b.key);
+  if(depth > 0 && e != NULL && e->depth >= draft && e->bound == EXACT)
+    return e->score;
+
+  int moves[MAXMOVES];
+  int count = generatemoves(b, player, moves);
+  int value = isMax ? -999 : 999;
+  int best = -1;
+  for(int k = 0; k < count; k++)
   {
-    int value = -999;
-    int temp = -999;
-    int stakevalue = -999;
-    int raidvalue = -999;
-    for(int i = 0; i < b.states.size(); i++)
+    Undo undo;
+    makemove(b, player, squareof(moves[k]), israid(moves[k]), undo);
+    int score = minimax(b, depth + 1, depthLimit, !isMax, 1 - player);
+    unmakemove(b, undo);
+    if(STOPPED)
+      return 0;
+
+    if(best == -1 || (isMax && score > value) || (!isMax && score < value))
     {
-      if(b.states[i] == ".")
-      {
-        b.states[i] = player;
-        stakevalue = max(stakevalue, minimax(b, depth + 1, depthLimit, false, ENEMY));
-        b.states[i] = ".";
-      }
-      if(b.states[i] == player)
-        raidvalue = max(raidvalue, raid(b, depth, depthLimit, isMax, player, i, false, 0, 0));
-
-      if(stakevalue > raidvalue)
-      {
-        value = max(value, stakevalue);
-        if(value > b.temp2)
-        {
-          b.move = "Stake";
-          b.temp2 = value;
-          b.index = i;
-        }
-      } else if(raidvalue > stakevalue) {
-        value = max(value, raidvalue);
-        if(value > b.temp2)
-        {
-          b.move = "Raid";
-          b.temp2 = value;
-          b.index = i;
-        }
-      }
+      value = score;
+      best = moves[k];
     }
-    return value;
-  } else {
-    int value = 999;
-    int stakevalue = 999;
-    int raidvalue = 999;
-    for(int i = 0; i < b.states.size(); i++)
-    {
-      if(b.states[i] == ".")
-      {
-        b.states[i] = player;
-        stakevalue = min(stakevalue, minimax(b, depth + 1, depthLimit, true, PLAYER));
-        b.states[i] = ".";
-      }
-      if(b.states[i] == player)
-        raidvalue = min(raidvalue, raid(b, depth, depthLimit, isMax, player, i, false, 0, 0));
+  }
 
-      if(stakevalue < raidvalue)
-        value = min(value, stakevalue);
-      else if(raidvalue < stakevalue)
-        value = min(value, raidvalue);
-    }
-    return value;
+  if(depth == 0)
+  {
+    b.index = squareof(best);
+    b.move = israid(best) ? RAID : STAKE;
   }
-  return 0;
+  TABLE.store(b.key, draft, EXACT, value, best);
+  return value;
 }
 
 // alpha-beta pruning
-// compares scores achieved from stake and raid
-int alphabeta(Board& b, int depth, int depthLimit, bool isMax, string player, int al, int bt)
+// compares scores achieved from every stake and raid, in the order
+// scoremoves gives them. positions reached again are looked up in TABLE
+int alphabeta(Board& b, int depth, int depthLimit, bool isMax, int player, int al, int bt)
 {
   if(depth >= depthLimit || terminalstate(b))
     return calculateScore(b);
 
-  if(isMax)
+  if(timeup())
+    return 0;
+
+  int draft = min(depthLimit - depth, b.empties);
+  int hashmove = -1;
+  Entry* e = TABLE.probe(b.key);
+  if(e != NULL)
   {
-    int value = -999;
-    int temp = -999;
-    int stakevalue = -999;
-    int raidvalue = -999;
-    for(int i = 0; i < b.states.size(); i++)
+    if(depth > 0 && e->depth >= draft)
     {
-      if(b.states[i] == ".")
+      if(e->bound == EXACT)
+        return e->score;
+      if(e->bound == LOWER && e->score >= bt)
+        return e->score;
+      if(e->bound == UPPER && e->score <= al)
+        return e->score;
+    }
+    hashmove = e->move;
+  }
+  if(depth == 0 && b.move != NOMOVE)
+    hashmove = b.index * 2 + (b.move == RAID ? 1 : 0); // best move of the last search
+
+  int moves[MAXMOVES];
+  int scores[MAXMOVES];
+  int count = generatemoves(b, player, moves);
+  scoremoves(b, player, depth, hashmove, moves, count, scores);
+
+  int alpha = al;
+  int beta = bt;
+  int value = isMax ? -999 : 999;
+  int best = -1;
+  for(int k = 0; k < count; k++)
+  {
+    picknext(moves, scores, k, count);
+    Undo undo;
+    makemove(b, player, squareof(moves[k]), israid(moves[k]), undo);
+    int score = alphabeta(b, depth + 1, depthLimit, !isMax, 1 - player, al, bt);
+    unmakemove(b, undo);
+    if(STOPPED)
+      return 0;
+
+    if(isMax)
+    {
+      if(best == -1 || score > value)
       {
-        b.states[i] = player;
-        stakevalue = max(stakevalue, alphabeta(b, depth + 1, depthLimit, false, ENEMY, al, bt));
-        b.states[i] = ".";
+        value = score;
+        best = moves[k];
       }
-      if(b.states[i] == player)
-        raidvalue = max(raidvalue, raid(b, depth, depthLimit, isMax, player, i, true, al, bt));
-
-      if(stakevalue > raidvalue)
+      if(value >= bt)
       {
-        value = max(value, stakevalue);
-        if(value > b.temp2)
-        {
-          b.move = "Stake";
-          b.temp2 = value;
-          b.index = i;
-        }
-      } else if(raidvalue > stakevalue) {
-        value = max(value, raidvalue);
-        if(value > b.temp2)
-        {
-          b.move = "Raid";
-          b.temp2 = value;
-          b.index = i;
-        }
+        cutoff(b, player, depth, draft, moves[k]);
+        break;
       }
-
-      if(value >= bt) return value;
       al = max(al, value);
-    }
-    return value;
-  } else {
-    int value = 999;
-    int stakevalue = 999;
-    int raidvalue = 999;
-    for(int i = 0; i < b.states.size(); i++)
-    {
-      if(b.states[i] == ".")
+    } else {
+      if(best == -1 || score < value)
       {
-        b.states[i] = player;
-        stakevalue = min(stakevalue, alphabeta(b, depth + 1, depthLimit, true, PLAYER, al, bt));
-        b.states[i] = ".";
+        value = score;
+        best = moves[k];
+      }
+      if(value <= al)
+      {
+        cutoff(b, player, depth, draft, moves[k]);
+        break;
       }
-      if(b.states[i] == player)
-        raidvalue = min(raidvalue, raid(b, depth, depthLimit, isMax, player, i, true, al, bt));
-
-      if(stakevalue < raidvalue)
-        value = min(value, stakevalue);
-      else if(raidvalue < stakevalue)
-        value = min(value, raidvalue);
-
-      if(value <= al) return value;
       bt = min(bt, value);
     }
-    return value;
   }
-  return 0;
+
+  if(depth == 0)
+  {
+    b.index = squareof(best);
+    b.move = israid(best) ? RAID : STAKE;
+  }
+  int bound = EXACT;
+  if(value <= alpha)
+    bound = UPPER;
+  else if(value >= beta)
+    bound = LOWER;
+  TABLE.store(b.key, draft, bound, value, best);
+  return value;
 }
 
-int main()
+// iterative deepening: searches depth 1, 2, 3, ... until ms milliseconds
+// have passed or the whole game is searched. b keeps the best move of the
+// last search that finished, alphabeta tries it first in the next one
+void deepen(Board& b, bool ab, int ms)
+{
+  DEADLINE = chrono::steady_clock::now() + chrono::milliseconds(ms);
+  for(int depth = 1; depth <= b.empties; depth++)
+  {
+    TIMED = depth > 1; // the first search always finishes, so there is a move
+    if(ab)
+      alphabeta(b, 0, depth, true, PLAYER, -999, 999);
+    else
+      minimax(b, 0, depth, true, PLAYER);
+    if(STOPPED || chrono::steady_clock::now() >= DEADLINE)
+      break;
+  }
+  TIMED = false;
+}
+
+int main(int argc, char* argv[])
 {
   ofs.open("output.txt", std::ofstream::out | std::ofstream::trunc);
   fstream in;
@@ -381,18 +733,48 @@ int main()
   int depthLimit;
   int value;
   string state;
+  string player;
   Board board;
+  long long tablebytes = 16LL * 1024 * 1024;
+  int budget = 0; // milliseconds for iterative deepening, 0 for a fixed depth
+
+  for(int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if(arg == "--tt" && i + 1 < argc)
+      tablebytes = atoll(argv[++i]) * 1024 * 1024;
+    else if(arg == "--time" && i + 1 < argc)
+      budget = atoi(argv[++i]);
+    else
+    {
+      cerr << "Unknown option " << arg << "\n";
+      return 1;
+    }
+  }
 
   in.open("input.txt");
 
   in >> n;
   in >> alg;
-  in >> PLAYER;
+  in >> player;
 
-  if(PLAYER == "O")
-    ENEMY = "X";
+  if(n > MAXN)
+  {
+    cerr << "Boards larger than " << MAXN << "x" << MAXN << " are not supported\n";
+    return 1;
+  }
+  setsize(n);
+
+  if(player == "O")
+  {
+    PLAYER = O;
+    ENEMY = X;
+  }
   else
-    ENEMY = "O";
+  {
+    PLAYER = X;
+    ENEMY = O;
+  }
 
   in >> depthLimit;
 
@@ -405,67 +787,37 @@ int main()
   for(int i = 0; i < n; i++)
   {
     in >> state;
-    for(int j = 0; j < n; j++)
+    for(int j = 0; j < n && j < state.size(); j++)
     {
-      string temp = state.substr(j, 1);
-      board.states.push_back(temp);
+      if(state[j] == SYMBOL[X])
+        board.pieces[X].set(i * n + j);
+      else if(state[j] == SYMBOL[O])
+        board.pieces[O].set(i * n + j);
     }
   }
 
   in.close();
+  board.recount();
+  TABLE.resize(tablebytes);
+  resetorder();
 
-  if(alg == "MINIMAX")
+  if(budget > 0)
+    deepen(board, alg != "MINIMAX", budget);
+  else if(alg == "MINIMAX")
     minimax(board, 0, depthLimit, true, PLAYER);
   else
     alphabeta(board, 0, depthLimit, true, PLAYER, -999, 999);
 
-  char c = '@';
-  c += (board.index % n) + 1; // column
-
-  if(board.move == "Stake")
+  if(board.move != NOMOVE)
   {
-    ofs << c << (board.index / n) + 1 << " " << board.move;
-    board.states[board.index] = PLAYER;
-    printboard(board);
-  }
-  else
-  {
-    map<string, int> direction = { {"l", 0}, {"r", 1}, {"u", 2}, {"d", 3} };
-    int d = direction[board.dir];
-    int j = sqrt(board.states.size());
+    char c = '@';
+    c += (board.index % n) + 1; // column
+    ofs << c << (board.index / n) + 1 << " " << MOVES[board.move];
 
-    switch(d)
-    {
-      case 0:
-        c--;
-        ofs << c << (board.index / n) + 1 << " " << board.move;
-        board.states[board.index - 1] = PLAYER;
-        board = conquer(board, PLAYER, (board.index - 1), j);
-        printboard(board);
-        break;
-      case 1:
-        c++;
-        ofs << c << (board.index / n) + 1 << " " << board.move;
-        board.states[board.index + 1] = PLAYER;
-        board = conquer(board, PLAYER, (board.index + 1), j);
-        printboard(board);
-        break;
-      case 2:
-        ofs << c << (board.index / n) << " " << board.move;
-        board.states[board.index - j] = PLAYER;
-        board = conquer(board, PLAYER, (board.index - j), j);
-        printboard(board);
-        break;
-      case 3:
-        ofs << c << (board.index / n) + 2 << " " << board.move;
-        board.states[board.index + j] = PLAYER;
-        board = conquer(board, PLAYER, (board.index + j), j);
-        printboard(board);
-        break;
-      default:
-        break;
-    }
+    Undo undo;
+    makemove(board, PLAYER, board.index, board.move == RAID, undo);
   }
+  printboard(board);
 
   ofs.close();
 